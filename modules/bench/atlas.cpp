@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.hpp"
+#include "geo.hpp"
+
+// Storage layout preceding the paged page table, kept for comparison.
+namespace legacy {
+template <std::size_t N>
+class Atlas {
+public:
+    constexpr Atlas() noexcept = default;
+    constexpr ~Atlas() noexcept = default;
+
+    constexpr void resize(int id, int idx, int num, int mode) {
+        if (mode == 0) {
+            if (storage.find(id) != storage.end())
+                clear(id);
+
+            return;
+        }
+
+        auto &chunk = storage[id];
+        const int size = static_cast<int>(chunk.size());
+
+        if (num < size) {
+            std::vector<Block> temp(chunk.begin(), chunk.begin() + num);
+            chunk.swap(temp);
+        } else if (num > size) {
+            chunk.resize(num);
+        }
+
+        auto &block = chunk.at(idx);
+
+        if (mode == 1 || block.size() == 1)
+            return;
+
+        if (auto it = block.find(0); it != block.end()) {
+            auto node = block.extract(it);
+            Block{}.swap(block);
+            block.insert(std::move(node));
+        }
+    }
+
+    constexpr void write(int id, int idx, int pos, const Geo &geo) noexcept {
+        const auto [key, offset] = split_pos(pos);
+
+        auto it = storage.find(id);
+        if (it == storage.end())
+            return;
+
+        auto &chunk = it->second;
+        if (idx >= static_cast<int>(chunk.size()))
+            return;
+
+        auto &unit = chunk[idx][key];
+
+        if (unit[offset].is_cached(geo))
+            return;
+
+        unit[offset] = geo;
+    }
+
+    constexpr void overwrite(int id, int idx, int pos, const Geo &geo) noexcept {
+        const auto [key, offset] = split_pos(pos);
+
+        auto it = storage.find(id);
+        if (it == storage.end())
+            return;
+
+        auto &chunk = it->second;
+        if (idx >= static_cast<int>(chunk.size()))
+            return;
+
+        auto &unit = chunk[idx][key];
+
+        unit[offset] = geo;
+    }
+
+    [[nodiscard]] constexpr const Geo *read(int id, int idx, int pos) const noexcept {
+        const auto [key, offset] = split_pos(pos);
+
+        if (auto unit = fetch(id, idx, key); unit && (*unit)[offset].is_valid())
+            return &(*unit)[offset];
+        else
+            return nullptr;
+    }
+
+    constexpr void clear() noexcept { Storage{}.swap(storage); }
+
+    constexpr void clear(int id) noexcept {
+        auto it = storage.find(id);
+        if (it == storage.end())
+            return;
+
+        auto &chunk = it->second;
+        std::vector<Block>{}.swap(chunk);
+        storage.erase(id);
+    }
+
+private:
+    using Unit = std::array<Geo, N>;
+    using Block = std::map<int, Unit>;
+    using Storage = std::unordered_map<int, std::vector<Block>>;
+    Storage storage{};
+
+    [[nodiscard]] constexpr std::array<int, 2> split_pos(int pos) const noexcept {
+        constexpr int size = static_cast<int>(N);
+        return {pos / size, pos % size};
+    }
+
+    [[nodiscard]] constexpr const Unit *fetch(int id, int idx, int key) const noexcept {
+        auto it_id = storage.find(id);
+        if (it_id == storage.end())
+            return nullptr;
+
+        auto &chunk = it_id->second;
+        if (idx >= static_cast<int>(chunk.size()))
+            return nullptr;
+
+        auto &block = chunk[idx];
+        auto it_key = block.find(key);
+        if (it_key == block.end())
+            return nullptr;
+
+        return &it_key->second;
+    }
+};
+}  // namespace legacy
+
+constexpr int ids = 64;
+constexpr int num = 16;
+constexpr int frames = 512;
+
+static Geo
+make_geo(int frame) noexcept {
+    const double t = static_cast<double>(frame);
+    return Geo(frame, t, -t, t * 0.5, t * 0.25, t * 0.1, 1.0, 1.0);
+}
+
+template <typename A>
+static void
+fill(A &atlas) {
+    for (int frame = 0; frame < frames; ++frame)
+        for (int id = 0; id < ids; ++id)
+            for (int idx = 0; idx < num; ++idx) {
+                atlas.resize(id, idx, num, 1);
+                atlas.overwrite(id, idx, frame + 1, make_geo(frame));
+            }
+}
+
+template <typename A>
+static void
+run(const char *label) {
+    std::printf("[%s]\n", label);
+    constexpr std::size_t total = static_cast<std::size_t>(ids) * num * frames;
+
+    bench::measure("sequential render (resize + overwrite + read)", total, [] {
+        A atlas;
+        for (int frame = 0; frame < frames; ++frame)
+            for (int id = 0; id < ids; ++id)
+                for (int idx = 0; idx < num; ++idx) {
+                    atlas.resize(id, idx, num, 1);
+                    atlas.overwrite(id, idx, frame + 1, make_geo(frame));
+                    bench::keep(atlas.read(id, idx, frame));
+                }
+    });
+
+    A atlas;
+    fill(atlas);
+
+    bench::measure("sequential read", total, [&] {
+        for (int id = 0; id < ids; ++id)
+            for (int idx = 0; idx < num; ++idx)
+                for (int frame = 0; frame < frames; ++frame) bench::keep(atlas.read(id, idx, frame + 1));
+    });
+
+    std::vector<std::array<int, 3>> keys(total);
+    std::mt19937 rng(42);
+    for (auto &k : keys)
+        k = {static_cast<int>(rng() % ids), static_cast<int>(rng() % num), static_cast<int>(rng() % (frames + 1))};
+
+    bench::measure("random scrubbing read", total, [&] {
+        for (const auto &[id, idx, pos] : keys) bench::keep(atlas.read(id, idx, pos));
+    });
+
+    bench::measure("random scrubbing write", total, [&] {
+        for (const auto &[id, idx, pos] : keys) atlas.write(id, idx, pos, make_geo(pos - 1));
+    });
+}
+
+// Particle-like object whose num swings between 1k and 50k from frame to frame; every index resizes, writes and reads
+// its previous frame, as compute_motion does.
+template <typename A>
+static void
+run_fluctuate(const char *label, const std::vector<int> &nums) {
+    std::size_t total = 0;
+    for (const int n : nums) total += static_cast<std::size_t>(n);
+
+    std::printf("[fluctuating num, %s]\n", label);
+    bench::measure("render (resize + overwrite + read)", total, [&] {
+        A atlas;
+        for (std::size_t frame = 0; frame < nums.size(); ++frame)
+            for (int idx = 0; idx < nums[frame]; ++idx) {
+                atlas.resize(0, idx, nums[frame], 1);
+                atlas.overwrite(0, idx, static_cast<int>(frame) + 1, make_geo(static_cast<int>(frame)));
+                bench::keep(atlas.read(0, idx, static_cast<int>(frame)));
+            }
+    }, 3);
+}
+
+// Indices cut off by a smaller num come back empty, those below the cut keep their history, and the pages of the
+// indices past num are gone within the frame that cut them, without evict().
+static bool
+check_fluctuate() {
+    Atlas<8> atlas;
+    auto render = [&](int frame, int n) {
+        for (int idx = 0; idx < n; ++idx) {
+            atlas.resize(0, idx, n, 1);
+            atlas.overwrite(0, idx, frame + 1, make_geo(frame));
+        }
+    };
+
+    render(0, 5000);
+    const std::size_t full = atlas.bytes();
+    render(1, 1000);
+    bool ok = atlas.page_count() == 1000 && atlas.bytes() * 4 < full;
+    render(2, 3000);
+    render(3, 2000);
+    ok &= atlas.page_count() == 2000;
+
+    for (int idx = 0; idx < 3000; ++idx) {
+        ok &= atlas.read(0, idx, 1).has_value() == (idx < 1000);
+        ok &= atlas.read(0, idx, 3).has_value() == (idx < 2000);
+    }
+
+    auto pages = [&] {
+        std::size_t count = 0;
+        atlas.for_each_page([&](std::uint64_t) { ++count; });
+        return count;
+    };
+    ok &= pages() == atlas.page_count();
+
+    atlas.evict(0);
+    const std::size_t live = atlas.page_count();
+    ok &= pages() == live && live == 2000;
+
+    std::printf("cut indices: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Minimal mode keeps the last frame at position 1. Rendering that frame again keeps what the first render wrote; the
+// next frame replaces it.
+static bool
+check_minimal() {
+    Atlas<8> atlas;
+    auto render = [&](int frame, double x) {
+        atlas.resize(0, 0, 1, 2);
+        atlas.write(0, 0, 1, Geo(frame, x, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+        return (*atlas.read(0, 0, 1))[0];
+    };
+
+    const bool ok = render(5, 1.0) == 1.0 && render(5, 2.0) == 1.0 && render(6, 3.0) == 3.0;
+    std::printf("minimal repeat: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// A geo 2^18 off base takes the unit of its page from 2^-16 to 2^-12. The geos held before round four more times
+// and stay within the new unit, but no longer within half of it, nor equal to the same geo written after.
+static bool
+check_requantize() {
+    const double unit = std::ldexp(1.0, -12), x = 7.4 * std::ldexp(1.0, -16);
+    const std::array<double, 5> xs{0.0, x, std::ldexp(1.0, 18), x, x};
+
+    Atlas<8> atlas;
+    atlas.resize(0, 0, 1, 1);
+    for (int i = 0; i < static_cast<int>(xs.size()); ++i)
+        atlas.overwrite(0, 0, 8 + i, Geo(7 + i, xs[i], 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+
+    double err = 0.0;
+    std::array<double, 5> decoded{};
+    for (int i = 0; i < static_cast<int>(xs.size()); ++i) {
+        decoded[i] = (*atlas.read(0, 0, 8 + i))[0];
+        err = std::max(err, std::abs(decoded[i] - xs[i]));
+    }
+
+    const bool ok = err <= unit && decoded[3] == decoded[4];
+    std::printf("requantized page: max error %.3f unit, held %g vs rewritten %g unit: %s\n", err / unit,
+                decoded[1] / unit, decoded[3] / unit, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Full mode over a long timeline of moves, holds and jumps: bytes per cached frame, decode cost and how far decoded
+// geos stray from the written ones, also as seen by Delta.
+static bool
+run_compact() {
+    constexpr int frames = 100000, objs = 4;
+    std::printf("[compact] %d objects x %d frames\n", objs, frames);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> jitter(-1.0, 1.0);
+    std::vector<Geo> geos(static_cast<std::size_t>(objs) * frames);
+    for (int idx = 0; idx < objs; ++idx) {
+        std::array<double, 7> v{0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0}, vel{};
+        for (int frame = 0; frame < frames; ++frame) {
+            // Holds, drifts and teleports, in spans of 64 frames.
+            switch ((frame / 64 + idx) % 4) {
+                case 0:
+                    vel = {};
+                    break;
+                case 1:
+                    for (std::size_t j = 0; j < 5; ++j) vel[j] = jitter(rng) * 40.0;
+                    break;
+                case 2:
+                    if (frame % 64 == 0)
+                        for (std::size_t j = 0; j < 5; ++j) v[j] += jitter(rng) * 5000.0;
+                    break;
+                default:
+                    vel[5] = vel[6] = jitter(rng) * 0.01;
+                    break;
+            }
+            for (std::size_t j = 0; j < v.size(); ++j) v[j] += vel[j];
+            geos[idx * frames + frame] = Geo(frame, v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+        }
+    }
+
+    Atlas<8> atlas;
+    for (int frame = 0; frame < frames; ++frame)
+        for (int idx = 0; idx < objs; ++idx) {
+            atlas.resize(0, idx, objs, 1);
+            atlas.overwrite(0, idx, frame + 1, geos[idx * frames + frame]);
+        }
+
+    const double stored = static_cast<double>(objs) * frames;
+    std::printf("bytes per cached frame: %.1f (Geo alone: %zu)\n", static_cast<double>(atlas.bytes()) / stored,
+                sizeof(Geo));
+
+    bench::measure("decode (sequential read)", static_cast<std::size_t>(stored), [&] {
+        for (int idx = 0; idx < objs; ++idx)
+            for (int frame = 0; frame < frames; ++frame) bench::keep(atlas.read(0, idx, frame + 1));
+    });
+
+    double err = 0.0;
+    int flips = 0;
+    for (int idx = 0; idx < objs; ++idx) {
+        for (int frame = 1; frame < frames; ++frame) {
+            const auto &curr = geos[idx * frames + frame];
+            const auto &prev = geos[idx * frames + frame - 1];
+            const auto decoded = atlas.read(0, idx, frame);
+            for (std::size_t j = 0; j < 7; ++j) err = std::max(err, std::abs((*decoded)[j] - prev[j]));
+
+            auto to = Transform(0.0, 0.0, 0.0, 0.0, 0.0, 100.0, 100.0), from = to, approx = to;
+            to.set_geo(curr);
+            from.set_geo(prev);
+            approx.set_geo(*decoded);
+            flips += Delta(from, to).is_moved() != Delta(approx, to).is_moved();
+        }
+    }
+
+    std::printf("max decode error %.3g, is_moved changed on %d frames\n", err, flips);
+    return err < 1.0e-4 && flips == 0;
+}
+
+int
+main() {
+    run<legacy::Atlas<8>>("map of vector of map");
+    run<Atlas<8>>("paged page table");
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> swing(1000, 50000);
+    std::vector<int> nums(64);
+    for (auto &n : nums) n = swing(rng);
+    run_fluctuate<legacy::Atlas<8>>("map of vector of map", nums);
+    run_fluctuate<Atlas<8>>("paged page table", nums);
+    const bool cut = check_fluctuate();
+    const bool requantized = check_requantize();
+    const bool minimal = check_minimal();
+
+    const bool ok = run_compact();
+    std::printf("compact: %s\n", ok ? "ok" : "FAILED");
+    return ok && cut && requantized && minimal ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::size_t> count{0};
+
+std::size_t
+bench::allocations() noexcept {
+    return count.load(std::memory_order_relaxed);
+}
+
+// Counting replacements of the global allocation functions. The array and nothrow forms forward to these.
+void *
+operator new(std::size_t size) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void
+operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
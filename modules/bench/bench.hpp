@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <string_view>
+
+namespace bench {
+// Number of global operator new calls so far (bench.cpp).
+[[nodiscard]] std::size_t allocations() noexcept;
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void
+keep(const T &value) noexcept {
+#if defined(_MSC_VER)
+    static const volatile void *sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+struct Result {
+    double ns;
+    double allocs;
+};
+
+// Best of several runs after a warm-up, which filters out scheduling noise.
+template <typename F>
+inline Result
+measure(std::string_view name, std::size_t ops, F &&fn, int runs = 5) {
+    fn();
+
+    double ns = std::numeric_limits<double>::max();
+    std::size_t allocs = 0;
+    for (int i = 0; i < runs; ++i) {
+        const std::size_t count = allocations();
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto stop = std::chrono::steady_clock::now();
+        ns = std::min(ns, std::chrono::duration<double, std::nano>(stop - start).count());
+        allocs = allocations() - count;
+    }
+
+    const Result result{ns / static_cast<double>(ops), static_cast<double>(allocs) / static_cast<double>(ops)};
+    std::printf("%-52.*s %12.2f ns/op %10.4f allocs/op\n", static_cast<int>(name.size()), name.data(), result.ns,
+                result.allocs);
+    return result;
+}
+}  // namespace bench
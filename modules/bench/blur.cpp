@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "blur.hpp"
+#include "motion.hpp"
+#include "pool.hpp"
+#include "structs.hpp"
+#include "transform.hpp"
+
+constexpr int w = 384, h = 384;
+
+// Opaque disc with a fine checker inside a transparent border, so both edges and texture are blurred.
+static std::vector<std::uint8_t>
+make_image() {
+    std::vector<std::uint8_t> px(static_cast<std::size_t>(w) * h * 4);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const double dx = x - w * 0.5, dy = y - h * 0.5;
+            if (dx * dx + dy * dy > 120.0 * 120.0)
+                continue;
+
+            auto *c = &px[(static_cast<std::size_t>(y) * w + x) * 4];
+            const bool on = ((x / 8) + (y / 8)) % 2;
+            c[0] = on ? 255 : 32;
+            c[1] = static_cast<std::uint8_t>(x * 255 / w);
+            c[2] = static_cast<std::uint8_t>(y * 255 / h);
+            c[3] = 255;
+        }
+    }
+    return px;
+}
+
+struct Case {
+    const char *name;
+    Transform curr;
+    double doubling;  // Mean difference of Doubling from Blur allowed, of 255.
+};
+
+// Largest distance, in pixels, between where the float kernels put a tap of the image corners and the double table.
+static void
+run_taps(const Delta &delta, double amt, int smp, const Vec2<double> &pivot) {
+    const auto taps = build_taps(delta, amt, smp);
+    const auto step = delta.build_xform(amt, smp, true);
+
+    double err_rec = 0.0, err_rec_f = 0.0, err_table_f = 0.0;
+    for (int corner = 0; corner < 4; ++corner) {
+        const Vec2<double> p(corner & 1 ? w - pivot.x() : -pivot.x(), corner & 2 ? h - pivot.y() : -pivot.y());
+
+        // The shader recurrence, in double and in float.
+        const auto pose = step.xform.to_mat2();
+        auto t = step.xform[2].to_vec2();
+        auto x = p;
+        double sx = step.scale[0], sy = step.scale[1];
+        double dx = step.drift.x(), dy = step.drift.y();
+
+        float tf[2] = {static_cast<float>(t.x()), static_cast<float>(t.y())};
+        float xf[2] = {static_cast<float>(p.x()), static_cast<float>(p.y())};
+        float sf[2] = {static_cast<float>(sx), static_cast<float>(sy)};
+        float df[2] = {static_cast<float>(dx), static_cast<float>(dy)};
+        const float pf[4] = {static_cast<float>(pose(0, 0)), static_cast<float>(pose(1, 0)),
+                             static_cast<float>(pose(0, 1)), static_cast<float>(pose(1, 1))};
+
+        for (int i = 1; i <= smp; ++i) {
+            const double *m = &taps[(i - 1) * 6];
+            const double rx = m[0] * p.x() + m[1] * p.y() + m[2];
+            const double ry = m[3] * p.x() + m[4] * p.y() + m[5];
+
+            x = pose * x + t;
+            err_rec = std::max(err_rec, std::hypot(sx * x.x() + dx - rx, sy * x.y() + dy - ry));
+            t = pose * t;
+            sx *= step.scale[0], sy *= step.scale[1];
+            dx += step.drift.x(), dy += step.drift.y();
+
+            const float qx = pf[0] * xf[0] + pf[2] * xf[1] + tf[0];
+            const float qy = pf[1] * xf[0] + pf[3] * xf[1] + tf[1];
+            xf[0] = qx, xf[1] = qy;
+            err_rec_f = std::max(err_rec_f, std::hypot(sf[0] * qx + df[0] - rx, sf[1] * qy + df[1] - ry));
+            const float ux = pf[0] * tf[0] + pf[2] * tf[1], uy = pf[1] * tf[0] + pf[3] * tf[1];
+            tf[0] = ux, tf[1] = uy;
+            sf[0] *= static_cast<float>(step.scale[0]), sf[1] *= static_cast<float>(step.scale[1]);
+            df[0] += static_cast<float>(step.drift.x()), df[1] += static_cast<float>(step.drift.y());
+
+            const float fx = static_cast<float>(m[0]) * static_cast<float>(p.x()) +
+                             static_cast<float>(m[1]) * static_cast<float>(p.y()) + static_cast<float>(m[2]);
+            const float fy = static_cast<float>(m[3]) * static_cast<float>(p.x()) +
+                             static_cast<float>(m[4]) * static_cast<float>(p.y()) + static_cast<float>(m[5]);
+            err_table_f = std::max(err_table_f, std::hypot(fx - rx, fy - ry));
+        }
+    }
+
+    std::printf("  tap error over %d taps: recurrence %.2e (double), %.2e (float); table %.2e (float) px\n", smp,
+                err_rec, err_rec_f, err_table_f);
+}
+
+// Translation at half a texel per tap: TableBlur pays every tap, LineBlur the same at any count.
+template <typename Diff>
+static bool
+run_line(const Image &src, const Image &single, const Image &other, double amt, const Vec2<double> &pivot,
+         Diff &&diff) {
+    constexpr std::size_t pixels = static_cast<std::size_t>(w) * h;
+    const Transform prev(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0);
+
+    bool ok = true;
+    std::printf("[line] translation, 0.5 px per tap\n");
+    for (const int smp : {15, 63, 255}) {
+        const double travel = smp * 0.5 / amt;
+        for (const bool steep : {false, true}) {
+            const Delta delta(Transform(0.0, 0.0, steep ? travel * 0.3 : travel, steep ? -travel : travel * 0.4, 0.0,
+                                        1.0, 1.0),
+                              prev);
+            ok = ok && delta.is_translation();
+
+            const TableBlur table(build_taps(delta, amt, smp), pivot, 0.0);
+            const LineBlur line(delta.build_xform(amt, smp, true), smp + 1, 0.0);
+            const std::string name = std::to_string(smp + 1) + (steep ? " samples, steep)" : " samples)");
+            bench::measure("TableBlur::render (" + name, pixels, [&] { table.render(src, single); });
+            bench::measure("LineBlur::render (" + name, pixels, [&] { line.render(src, other); });
+            ok = ok && diff() < 1.0;
+        }
+    }
+
+    std::printf("line: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Spin about the centre at half a texel of arc per tap at the corners: RotationBlur does not pay for the angle.
+template <typename Diff>
+static bool
+run_spin(const Image &src, const Image &single, const Image &other, double amt, const Vec2<double> &pivot,
+         Diff &&diff) {
+    constexpr std::size_t pixels = static_cast<std::size_t>(w) * h;
+    const double radius = std::hypot(w * 0.5, h * 0.5);
+
+    bool ok = true;
+    std::printf("[spin] rotation about the centre, 0.5 px per tap at the corners\n");
+    for (const double deg : {5.0, 20.0, 80.0}) {
+        const Delta delta(Transform(0.0, 0.0, 0.0, 0.0, deg, 1.0, 1.0), Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+        const int smp = static_cast<int>(std::ceil(radius * to_rad(deg) * amt / 0.5));
+        ok = ok && delta.is_rotation() && !delta.is_translation();
+
+        const TableBlur table(build_taps(delta, amt, smp), pivot, 0.0);
+        const RotationBlur spin(delta.build_xform(amt, smp, true), pivot, smp + 1, 0.0);
+        const std::string name =
+                std::to_string(static_cast<int>(deg)) + " deg, " + std::to_string(smp + 1) + " samples)";
+        bench::measure("TableBlur::render (" + name, pixels, [&] { table.render(src, single); });
+        bench::measure("RotationBlur::render (" + name, pixels, [&] { spin.render(src, other); });
+        ok = ok && diff() < 1.0;
+    }
+
+    // A pivot far off the object only resamples the arcs that cross it.
+    const Vec2<double> far(-2.0 * w, h * 0.5);
+    const Delta delta(Transform(0.0, 0.0, 0.0, 0.0, 5.0, 1.0, 1.0), Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+    const int smp = static_cast<int>(std::ceil(std::hypot(3.0 * w, h * 0.5) * to_rad(5.0) * amt / 0.5));
+    const TableBlur table(build_taps(delta, amt, smp), far, 0.0);
+    const RotationBlur spin(delta.build_xform(amt, smp, true), far, smp + 1, 0.0);
+    const std::string name = "5 deg about a far pivot, " + std::to_string(smp + 1) + " samples)";
+    bench::measure("TableBlur::render (" + name, pixels, [&] { table.render(src, single); });
+    bench::measure("RotationBlur::render (" + name, pixels, [&] { spin.render(src, other); });
+    ok = ok && diff() < 1.0;
+
+    std::printf("spin: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Zoom about the centre at half a texel per tap at the corners: ZoomBlur does not pay for the factor.
+template <typename Diff>
+static bool
+run_zoom(const Image &src, const Image &single, const Image &other, double amt, const Vec2<double> &pivot,
+         Diff &&diff) {
+    constexpr std::size_t pixels = static_cast<std::size_t>(w) * h;
+    const double radius = std::hypot(w * 0.5, h * 0.5);
+
+    bool ok = true;
+    std::printf("[zoom] scale about the centre, 0.5 px per tap at the corners\n");
+    for (const double scale : {1.1, 1.5, 3.0}) {
+        const Delta delta(Transform(0.0, 0.0, 0.0, 0.0, 0.0, scale, scale),
+                          Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+        const int smp = static_cast<int>(std::ceil(radius * (std::pow(scale, amt) - 1.0) / 0.5));
+        ok = ok && delta.is_zoom() && !delta.is_rotation() && !delta.is_translation();
+
+        const TableBlur table(build_taps(delta, amt, smp), pivot, 0.0);
+        const ZoomBlur zoom(delta.build_xform(amt, smp, true), pivot, smp + 1, 0.0);
+        char name[64];
+        std::snprintf(name, sizeof(name), "x%.1f, %d samples)", scale, smp + 1);
+        bench::measure(std::string("TableBlur::render (") + name, pixels, [&] { table.render(src, single); });
+        bench::measure(std::string("ZoomBlur::render (") + name, pixels, [&] { zoom.render(src, other); });
+        ok = ok && diff() < 1.0;
+    }
+
+    const Vec2<double> far(-2.0 * w, h * 0.5);
+    const Delta delta(Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.1, 1.1), Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+    const int smp = static_cast<int>(std::ceil(std::hypot(3.0 * w, h * 0.5) * (std::pow(1.1, amt) - 1.0) / 0.5));
+    const TableBlur table(build_taps(delta, amt, smp), far, 0.0);
+    const ZoomBlur zoom(delta.build_xform(amt, smp, true), far, smp + 1, 0.0);
+    const std::string name = "x1.1 about a far pivot, " + std::to_string(smp + 1) + " samples)";
+    bench::measure("TableBlur::render (" + name, pixels, [&] { table.render(src, single); });
+    bench::measure("ZoomBlur::render (" + name, pixels, [&] { zoom.render(src, other); });
+    ok = ok && diff() < 1.0;
+
+    std::printf("zoom: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// A long move and turn with few samples, against every tap the travel asks for: clamped taps leave copies of the object
+// along the path where the mip level fills the gaps.
+template <typename Diff>
+static bool
+run_mip(const Image &src, const Image &single, const Image &other, double amt, const Vec2<double> &pivot,
+        Diff &&diff) {
+    constexpr std::size_t pixels = static_cast<std::size_t>(w) * h;
+
+    const Delta delta(Transform(0.0, 0.0, 900.0, 300.0, 60.0, 1.0, 1.0), Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+    const Context context("bench blur", w, h, 0.0, 0.0, 0, 0, 1, 1, 2);
+    const int req = static_cast<int>(std::ceil(max_travel(context, delta, amt)));
+
+    const TableBlur full(build_taps(delta, amt, req), pivot, 0.0);
+    std::printf("[mip] %d px of travel\n", req);
+    bench::measure("TableBlur::render (" + std::to_string(req + 1) + " samples)", pixels,
+                   [&] { full.render(src, single); });
+
+    bool ok = true;
+    for (const int smp : {15, 31, 63}) {
+        const int lod = mip_level(req, smp);
+        const auto taps = build_taps(delta, amt, smp);
+        const TableBlur clamped(taps, pivot, 0.0);
+        const MipBlur mip(taps, pivot, lod, 0.0);
+
+        const std::string name = std::to_string(smp + 1) + " samples";
+        bench::measure("TableBlur::render (" + name + ", clamped)", pixels, [&] { clamped.render(src, other); });
+        const double err_clamped = diff();
+        bench::measure("MipBlur::render (" + name + ", level " + std::to_string(lod) + ")", pixels,
+                       [&] { mip.render(src, other); });
+        ok = ok && diff() < err_clamped;
+    }
+
+    std::printf("mip: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Fixed-point taps on the 8-bit image and half-float taps on the float levels of MipBlur, against f32. Throughput is
+// taken at 64 samples. The error is swept over sample counts up to 4096 on a window across the edge of the disc,
+// where it is largest: one level at most, which is what rounding to 8 bits costs anyway.
+static bool
+run_precision(const Image &src, const Image &single, const Image &other, double amt, const Vec2<double> &pivot) {
+    constexpr std::size_t pixels = static_cast<std::size_t>(w) * h;
+    constexpr int size = 96, x0 = 264, y0 = 144;
+
+    const Delta delta(Transform(10.0, 0.0, 60.0, -20.0, 25.0, 1.3, 0.9), Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+    const auto taps = build_taps(delta, amt, 63);
+
+    std::printf("[precision] 64 samples\n");
+    const TableBlur table(taps, pivot, 0.0);
+    const TableBlur fixed(taps, pivot, 0.0, 0, Precision::fixed8);
+    bench::measure("TableBlur::render (f32)", pixels, [&] { table.render(src, single); });
+    bench::measure("TableBlur::render (fixed8)", pixels, [&] { fixed.render(src, other); });
+
+    const MipBlur mip(taps, pivot, 2, 0.0);
+    const MipBlur half(taps, pivot, 2, 0.0, Precision::f16);
+    bench::measure("MipBlur::render (level 2, f32)", pixels, [&] { mip.render(src, single); });
+    bench::measure("MipBlur::render (level 2, f16)", pixels, [&] { half.render(src, other); });
+
+    auto window = [&](const Image &img) {
+        return Image{static_cast<std::uint8_t *>(img.data) + y0 * img.pitch + x0 * 4, size, size, img.pitch, img.depth};
+    };
+    const Image part = window(src), ref = window(single), out = window(other);
+    const Vec2<double> center(size * 0.5, size * 0.5);
+
+    struct Error {
+        double mean = 0.0;
+        int max = 0;
+    };
+    auto compare = [&](Error &err) {
+        double sum = 0.0;
+        for (int y = 0; y < size; ++y) {
+            const auto *a = static_cast<const std::uint8_t *>(ref.data) + y * ref.pitch;
+            const auto *b = static_cast<const std::uint8_t *>(out.data) + y * out.pitch;
+            for (int i = 0; i < size * 4; ++i) {
+                const int d = std::abs(a[i] - b[i]);
+                sum += d;
+                err.max = std::max(err.max, d);
+            }
+        }
+        err.mean = std::max(err.mean, sum / (size * size * 4));
+    };
+
+    Error err_fixed, err_half;
+    for (const int smp : {1, 2, 3, 7, 8, 15, 16, 31, 32, 63, 64, 127, 128, 255, 256, 511, 512, 1023, 1024, 2047,
+                          2048, 4095}) {
+        const auto sweep = build_taps(delta, amt, smp);
+        TableBlur(sweep, center, 0.0).render(part, ref);
+        TableBlur(sweep, center, 0.0, 0, Precision::fixed8).render(part, out);
+        compare(err_fixed);
+
+        MipBlur(sweep, center, 3, 0.0).render(part, ref);
+        MipBlur(sweep, center, 3, 0.0, Precision::f16).render(part, out);
+        compare(err_half);
+    }
+
+    std::printf("  fixed8 vs f32 up to 4096 samples: mean %.3f, max %d (of 255)\n", err_fixed.mean, err_fixed.max);
+    std::printf("  f16 vs f32 up to 4096 samples: mean %.3f, max %d (of 255)\n", err_half.mean, err_half.max);
+
+    const bool ok = err_fixed.max <= 1 && err_half.max <= 1;
+    std::printf("precision: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Tiles of a spin about the centre: the corners need every sample, the middle hardly any. Against TableBlur with the
+// samples of the worst tile everywhere, the output may only differ where a tile rounds its own count up.
+template <typename Diff>
+static bool
+run_tiled(const Image &src, const Image &single, const Image &other, double amt, const Vec2<double> &pivot,
+          Diff &&diff) {
+    constexpr int size = 32;
+    constexpr std::size_t pixels = static_cast<std::size_t>(w) * h;
+
+    const Delta delta(Transform(0.0, 0.0, 0.0, 0.0, 40.0, 1.0, 1.0), Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0));
+    const auto tiles = build_tiles(delta, amt, 1.0, max_taps, w, h, pivot, size);
+
+    const int most = std::ranges::max(tiles.smp);
+    std::size_t used = 0;
+    for (int row = 0; row < tiles.rows; ++row)
+        for (int col = 0; col < tiles.cols; ++col)
+            used += static_cast<std::size_t>(tiles.smp[row * tiles.cols + col] + 1) *
+                    (std::min(size, w - col * size) * std::min(size, h - row * size));
+
+    const bool shape_ok = tiles.cols == (w + size - 1) / size && tiles.rows == (h + size - 1) / size &&
+                          tiles.smp.front() == most && tiles.smp.back() == most &&
+                          tiles.smp[tiles.rows / 2 * tiles.cols + tiles.cols / 2] < most / 4;
+
+    std::printf("[tiled] rotate, %dx%d tiles of %d px, at most %d samples\n", tiles.cols, tiles.rows, size, most + 1);
+    std::printf("  samples: %.1f per pixel vs %d\n", static_cast<double>(used) / pixels, most + 1);
+
+    const TableBlur table(build_taps(delta, amt, most), pivot, 0.0);
+    const TiledBlur tiled(delta, amt, tiles, pivot, 0.0);
+    bench::measure("TableBlur::render (rotate, worst tile everywhere)", pixels, [&] { table.render(src, single); });
+    bench::measure("TiledBlur::render (rotate)", pixels, [&] { tiled.render(src, other); });
+    const bool blur_ok = diff() < 0.5;
+
+    std::printf("tiles: %s\n", shape_ok && blur_ok ? "ok" : "FAILED");
+    return shape_ok && blur_ok;
+}
+
+// Tasks that sleep rather than spin, so workers overlap even on one core. Task 0 is costed like the rest but takes as
+// long as a whole queue, so the others only finish early by stealing from its owner.
+static bool
+run_pool() {
+    constexpr std::size_t tasks = 64;
+    constexpr unsigned workers = 3;
+    const std::vector<std::size_t> costs(tasks, 1);
+
+    std::vector<std::atomic<int>> calls(tasks);
+    const auto task = [&](std::size_t i) {
+        calls[i].fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::microseconds(i == 0 ? 4000 : 100));
+    };
+
+    using Ms = std::chrono::duration<double, std::milli>;
+
+    Pool serial(0);
+    auto start = std::chrono::steady_clock::now();
+    const std::size_t serial_stolen = serial.run(costs, task);
+    const double serial_ms = Ms(std::chrono::steady_clock::now() - start).count();
+
+    Pool pool(workers);
+    start = std::chrono::steady_clock::now();
+    const std::size_t stolen = pool.run(costs, task);
+    const double pool_ms = Ms(std::chrono::steady_clock::now() - start).count();
+    pool.run(costs, task);
+
+    const bool once = std::ranges::all_of(calls, [](const std::atomic<int> &c) { return c.load() == 3; });
+    std::printf("[pool] %zu tasks, one slow: %.1f ms serial, %.1f ms on %u workers + caller, %zu stolen\n", tasks,
+                serial_ms, pool_ms, workers, stolen);
+
+    // Rows as the blurs run them: every row once, a run from inside a task inline, and an exception to the caller.
+    std::vector<std::atomic<int>> rows(1000);
+    std::atomic<int> inner = 0;
+    pool.run(rows.size(), [&](std::size_t y) {
+        rows[y].fetch_add(1);
+        if (y % 100 == 0)
+            pool.run(10, [&](std::size_t) { inner.fetch_add(1); });
+    });
+
+    bool thrown = false;
+    try {
+        pool.run(64, [](std::size_t i) {
+            if (i == 33)
+                throw std::runtime_error("task");
+        });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+
+    const bool rows_ok = std::ranges::all_of(rows, [](const std::atomic<int> &c) { return c.load() == 1; }) &&
+                         inner.load() == 100 && thrown;
+    std::printf("  rows: %s\n", rows_ok ? "every row once, nested runs inline, exception passed on" : "FAILED");
+
+    const bool ok = once && rows_ok && serial_stolen == 0 && stolen > 0 && pool_ms < serial_ms;
+    std::printf("pool: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int
+main() {
+    constexpr double amt = 0.5;
+    constexpr int num = 6;
+    constexpr std::size_t pixels = static_cast<std::size_t>(w) * h;
+
+    const Transform prev(0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0);
+    const Case cases[] = {
+            {"translate", Transform(0.0, 0.0, 60.0, 20.0, 0.0, 1.0, 1.0), 0.75},
+            {"rotate", Transform(0.0, 0.0, 0.0, 0.0, 40.0, 1.0, 1.0), 0.75},
+            {"zoom", Transform(0.0, 0.0, 0.0, 0.0, 0.0, 1.6, 1.6), 0.75},
+            {"slide and spin", Transform(0.0, 0.0, 60.0, 20.0, 40.0, 1.0, 1.0), 3.0},
+            {"mixed", Transform(10.0, 0.0, 30.0, -10.0, 25.0, 1.3, 0.9), 3.0},
+    };
+
+    auto src_px = make_image();
+    std::vector<std::uint8_t> single_px(src_px.size()), other_px(src_px.size());
+    const Image src{src_px.data(), w, h, w * 4, Depth::u8};
+    const Image single{single_px.data(), w, h, w * 4, Depth::u8};
+    const Image other{other_px.data(), w, h, w * 4, Depth::u8};
+    const Vec2<double> pivot(w * 0.5, h * 0.5);
+
+    auto diff = [&] {
+        double sum = 0.0;
+        int max = 0;
+        for (std::size_t i = 0; i < src_px.size(); ++i) {
+            const int d = std::abs(single_px[i] - other_px[i]);
+            sum += d;
+            max = std::max(max, d);
+        }
+
+        const double mean = sum / static_cast<double>(src_px.size());
+        std::printf("  difference: mean %.3f, max %d (of 255)\n", mean, max);
+        return mean;
+    };
+
+    bool ok = true;
+    std::printf("[blur] %dx%d, %d samples\n", w, h, 1 << num);
+    for (const auto &c : cases) {
+        const Delta delta(c.curr, prev);
+        const int smp = (1 << num) - 1;
+        const Blur blur(delta.build_xform(amt, smp, true), pivot, smp + 1, 0.0);
+        const TableBlur table(build_taps(delta, amt, smp), pivot, 0.0);
+        const Doubling passes(build_passes(delta, amt, num), pivot, 0.0);
+
+        const std::string name = c.name;
+        bench::measure("Blur::render (" + name + ")", pixels, [&] { blur.render(src, single); });
+
+        bench::measure("TableBlur::render (" + name + ")", pixels, [&] { table.render(src, other); });
+        ok = ok && diff() < 0.05;
+
+        // Every pass filters bilinearly again, which alone softens a single motion a little. Translation combined with
+        // rotation or scale also takes the arc of the powered step instead of the path of build_xform; see
+        // build_passes.
+        bench::measure("Doubling::render (" + name + ", 6 passes)", pixels, [&] { passes.render(src, other); });
+        ok = ok && diff() < c.doubling;
+
+        run_taps(delta, amt, max_taps, pivot);
+    }
+
+    ok = run_line(src, single, other, amt, pivot, diff) && ok;
+    ok = run_spin(src, single, other, amt, pivot, diff) && ok;
+    ok = run_zoom(src, single, other, amt, pivot, diff) && ok;
+    ok = run_mip(src, single, other, amt, pivot, diff) && ok;
+    ok = run_tiled(src, single, other, amt, pivot, diff) && ok;
+    ok = run_precision(src, single, other, amt, pivot) && ok;
+    ok = run_pool() && ok;
+    return ok ? 0 : 1;
+}
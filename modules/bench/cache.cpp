@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "cache.hpp"
+#include "motion.hpp"
+#include "structs.hpp"
+
+// Concurrent compute() on one GeoCache: a stress run over every cache and purge mode, a check that threads on disjoint
+// ids reproduce a serial run, throughput from 1 to N threads, a long project under a byte budget, and frame 0 of the
+// transform history across renders.
+constexpr int num = 8, frames = 64;
+
+static Transform
+make_xform(int id, double t) noexcept {
+    return Transform(0.0, 0.0, std::cos(t * 0.1 + id) * 300.0, std::sin(t * 0.07) * 150.0, t * (id % 5), 100.0,
+                     100.0 + id % 3);
+}
+
+static double
+step(GeoCache &cache, const Param &param, int id, int idx, int frame, int range = frames) {
+    const double t = static_cast<double>(frame);
+    const Context context("bench", 200.0, 100.0, 0.0, 0.0, id, idx, num, frame, range);
+    Flow flow(make_xform(id, t), make_xform(id, t - 1.0),
+              Geo(frame, 0.0, 0.0, std::sin(t * 0.3 + idx) * 20.0, idx * 4.0, t, 1.0, 1.0), nullptr);
+
+    const auto result = compute(cache, param, context, flow);
+    return result.smp + result.margin[0].x() + result.margin[1].y();
+}
+
+// Every id of ids through all frames; a checksum per id.
+static void
+run_ids(GeoCache &cache, const std::vector<int> &ids, std::vector<double> &sums) {
+    const Param param(0.5, 256, 0.0, 1.0, false, 2, 1, 1, 0.0, 0, 0, false);
+    for (int frame = 0; frame < frames; ++frame)
+        for (int id : ids)
+            for (int idx = 0; idx < num; ++idx) sums[id] += step(cache, param, id, idx, frame);
+}
+
+static bool
+run_disjoint(int threads) {
+    constexpr int ids = 64;
+
+    std::vector<double> serial(ids), parallel(ids);
+    {
+        GeoCache cache;
+        std::vector<int> all(ids);
+        for (int i = 0; i < ids; ++i) all[i] = i;
+        run_ids(cache, all, serial);
+    }
+    {
+        GeoCache cache;
+        std::vector<std::jthread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                std::vector<int> own;
+                for (int i = t; i < ids; i += threads) own.push_back(i);
+                run_ids(cache, own, parallel);
+            });
+        }
+    }
+
+    const bool same = serial == parallel;
+    std::printf("disjoint ids, %d threads: %s\n", threads, same ? "identical to serial" : "MISMATCH");
+    return same;
+}
+
+// Few ids shared by all threads, random modes including purging everything. Only has to stay consistent.
+static bool
+run_stress(int threads) {
+    constexpr int calls = 20000;
+    GeoCache cache;
+    std::atomic<int> bad = 0;
+
+    {
+        std::vector<std::jthread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                std::uniform_int_distribution<int> id(0, 5), idx(0, num - 1), frame(0, frames - 1), mode(0, 2),
+                        purge(0, 3), ext(0, 2);
+
+                for (int i = 0; i < calls; ++i) {
+                    const Param param(0.5, 256, 0.0, 1.0, false, ext(rng), mode(rng), i % 97 ? 0 : purge(rng), 0.0,
+                                      0, 0, false);
+                    if (!std::isfinite(step(cache, param, id(rng), idx(rng), frame(rng))))
+                        ++bad;
+                }
+            });
+        }
+    }
+
+    std::printf("stress, %d threads x %d calls: %s\n", threads, calls, bad ? "FAILED" : "ok");
+    return !bad;
+}
+
+static void
+run_scaling(int max_threads) {
+    constexpr int ids = 256;
+    std::printf("[scaling] %d ids x %d idx x %d frames\n", ids, num, frames);
+
+    double base = 0.0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::vector<double> sums(ids);
+        const auto start = std::chrono::steady_clock::now();
+        {
+            GeoCache cache;
+            std::vector<std::jthread> pool;
+            for (int t = 0; t < threads; ++t) {
+                pool.emplace_back([&, t] {
+                    std::vector<int> own;
+                    for (int i = t; i < ids; i += threads) own.push_back(i);
+                    run_ids(cache, own, sums);
+                });
+            }
+        }
+        const auto stop = std::chrono::steady_clock::now();
+
+        const double rate = ids * num * frames / std::chrono::duration<double>(stop - start).count();
+        if (threads == 1)
+            base = rate;
+        std::printf("%2d threads: %10.0f calls/s (x%.2f)\n", threads, rate, rate / base);
+    }
+}
+
+// Full geo cache over a long project. Every call leaves the usage within the budget, and the ids of the current frame
+// keep their pages.
+static bool
+run_budget() {
+    constexpr int ids = 64, range = 2048;
+    constexpr double limit = 2.0;
+
+    bool ok = true;
+    std::printf("[budget] %d ids x %d idx x %d frames, Full\n", ids, num, range);
+    for (const double mib : {0.0, limit}) {
+        const Param param(0.5, 256, 0.0, 1.0, false, 0, 1, 0, mib, 0, 0, false);
+        GeoCache cache;
+        std::size_t peak = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < range; ++frame)
+            for (int id = 0; id < ids; ++id)
+                for (int idx = 0; idx < num; ++idx) step(cache, param, id, idx, frame, range);
+        const auto stop = std::chrono::steady_clock::now();
+
+        const auto usage = cache.usage();
+        peak = std::max(peak, usage.bytes);
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count() / (ids * num * range);
+        std::printf("limit %4.1f MiB: %8.1f KiB in %zu ids / %zu pages, evicted %llu ids / %llu pages, %.0f ns/call\n",
+                    mib, usage.bytes / 1024.0, usage.ids, usage.pages,
+                    static_cast<unsigned long long>(usage.evicted_ids),
+                    static_cast<unsigned long long>(usage.evicted_pages), ns);
+
+        if (mib > 0.0)
+            ok = ok && usage.bytes <= usage.budget && usage.ids == ids;
+    }
+
+    // The running total must match a full recount after eviction, purges and clears.
+    {
+        GeoCache cache;
+        const Param param(0.5, 256, 0.0, 1.0, false, 2, 2, 0, 0.25, 0, 0, false);
+        for (int frame = 0; frame < 256; ++frame)
+            for (int id = 0; id < ids; ++id)
+                for (int idx = 0; idx < num; ++idx) step(cache, param, id, idx, frame, 256);
+
+        const auto usage = cache.usage();
+        cache.clear();
+        const auto empty = cache.usage();
+        std::printf("minimal cache at 0.25 MiB: %.1f KiB, %zu pages; after clear: %zu pages\n", usage.bytes / 1024.0,
+                    usage.pages, empty.pages);
+        ok = ok && usage.bytes <= usage.budget && !empty.pages && !empty.ids;
+    }
+
+    // Hash tables keep their size once their ids are gone, and no eviction frees it. With most of the budget taken by
+    // them, the ids in use must still stay rather than be evicted on every call.
+    {
+        GeoCache cache;
+        const Param wide(0.5, 256, 0.0, 1.0, false, 0, 1, 0, 0.0, 0, 0, false);
+        for (int id = ids; id < ids + 32768; ++id) step(cache, wide, id, 0, 0, 1);
+
+        const Param param(0.5, 256, 0.0, 1.0, false, 0, 1, 0, 0.375, 0, 0, false);
+        const auto before = cache.usage();
+        for (int frame = 0; frame < 256; ++frame)
+            for (int id = 0; id < ids; ++id)
+                for (int idx = 0; idx < num; ++idx) step(cache, param, id, idx, frame, 256);
+
+        const auto usage = cache.usage();
+        const auto evicted = usage.evicted_ids - before.evicted_ids - 32768;
+        std::printf("fixed overhead over 0.375 MiB: %.1f KiB in %zu ids, %llu ids of %d evicted over %d calls\n",
+                    usage.bytes / 1024.0, usage.ids, static_cast<unsigned long long>(evicted), ids, 256 * ids * num);
+        ok = ok && evicted < ids * 4;
+    }
+
+    std::printf("budget: %s\n", ok ? "ok" : "EXCEEDED");
+    return ok;
+}
+
+// A second render reaching frame 0 must not extrapolate from frames 1 and 2 of the first, which an edit may have
+// changed; playing backwards from frame 2 must.
+static bool
+run_history() {
+    History history;
+    const Transform curr = make_xform(0, 0.0);
+    for (int frame = 0; frame < frames; ++frame) history.record(0, 0, 1, frame, make_xform(0, frame));
+
+    bool ok = !history.prev(0, 0, 0, 1, curr) && !history.prev(0, 0, 0, 2, curr);
+
+    history.record(0, 0, 1, 2, make_xform(0, 2.0));
+    history.record(0, 0, 1, 1, make_xform(0, 1.0));
+    const auto linear = history.prev(0, 0, 0, 1, curr), quadratic = history.prev(0, 0, 0, 2, curr);
+    ok = ok && linear && quadratic && (*linear)[2] == curr[2] * 2.0 - make_xform(0, 1.0)[2];
+
+    history.record(0, 0, 1, 5, make_xform(0, 5.0));
+    history.record(0, 0, 1, 1, make_xform(0, 1.0));
+    ok = ok && history.prev(0, 0, 0, 1, curr) && !history.prev(0, 0, 0, 2, curr);
+
+    std::printf("history at frame 0: %s\n", ok ? "ok" : "STALE");
+    return ok;
+}
+
+int
+main() {
+    const int hw = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    const int threads = std::max(hw, 4);
+
+    bool ok = run_disjoint(threads);
+    ok = run_stress(threads) && ok;
+    run_scaling(std::max(hw, 8));
+    ok = run_budget() && ok;
+    ok = run_history() && ok;
+    return ok ? 0 : 1;
+}
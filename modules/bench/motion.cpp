@@ -0,0 +1,483 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "bench.hpp"
+#include "geo.hpp"
+#include "host.hpp"
+#include "motion.hpp"
+#include "script.hpp"
+#include "structs.hpp"
+#include "transform.hpp"
+
+constexpr std::size_t count = 1 << 12;
+
+static std::vector<Transform>
+make_xforms(std::mt19937 &rng) {
+    std::uniform_real_distribution<double> pos(-500.0, 500.0);
+    std::uniform_real_distribution<double> rot(-180.0, 180.0);
+    std::uniform_real_distribution<double> scl(0.5, 2.0);
+
+    std::vector<Transform> xforms(count);
+    for (auto &x : xforms) x = Transform(pos(rng) * 0.1, pos(rng) * 0.1, pos(rng), pos(rng), rot(rng), scl(rng), scl(rng));
+    return xforms;
+}
+
+static Geo
+make_geo(int frame) noexcept {
+    const double t = static_cast<double>(frame);
+    return Geo(frame, t * 0.1, -t * 0.1, t, t * 0.5, t * 0.25, 1.0, 1.0);
+}
+
+static void
+run_delta(std::mt19937 &rng) {
+    const auto from = make_xforms(rng);
+    const auto to = make_xforms(rng);
+    const Context context("bench", 640.0, 360.0, 12.0, -8.0, 0, 0, 1, 1, 100);
+
+    std::vector<Delta> deltas;
+    deltas.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) deltas.emplace_back(from[i], to[i]);
+
+    std::printf("[delta]\n");
+    bench::measure("Delta(from, to)", count, [&] {
+        for (std::size_t i = 0; i < count; ++i) bench::keep(Delta(from[i], to[i]));
+    });
+    bench::measure("Delta::build_xform(amt, 1)", count, [&] {
+        for (const auto &d : deltas) bench::keep(d.build_xform(0.5));
+    });
+    bench::measure("Delta::build_xform(amt, 256, true)", count, [&] {
+        for (const auto &d : deltas) bench::keep(d.build_xform(0.5, 256, true));
+    });
+    bench::measure("resize(context, delta, amt)", count, [&] {
+        for (const auto &d : deltas) bench::keep(resize(context, d, 0.5));
+    });
+    bench::measure("max_travel(context, delta, amt)", count, [&] {
+        for (const auto &d : deltas) bench::keep(max_travel(context, d, 0.5));
+    });
+    bench::measure("build_taps(delta, amt, 255)", count, [&] {
+        for (const auto &d : deltas) bench::keep(build_taps(d, 0.5, 255));
+    });
+
+    // Required samples from the bounding box margins versus the corner path length.
+    double by_margin = 0.0, by_travel = 0.0;
+    for (const auto &d : deltas) {
+        const auto margin = resize(context, d, 0.5);
+        by_margin += std::ceil((margin[0] + margin[1]).norm<2>());
+        by_travel += std::ceil(max_travel(context, d, 0.5));
+    }
+    std::printf("mean required samples: margin %.1f, travel %.1f\n", by_margin / count, by_travel / count);
+}
+
+static void
+run_extrapolate() {
+    constexpr int num = 64;
+    const Param param(0.5, 256, 0.0, 1.0, false, 2, 1, 0, 0.0, 0, 0, false);
+
+    AtlasOct atlas;
+    for (int idx = 0; idx < num; ++idx) {
+        atlas.resize(0, idx, num, param.geo_cache);
+        atlas.overwrite(0, idx, 2, make_geo(1));
+        atlas.overwrite(0, idx, 3, make_geo(2));
+    }
+
+    std::vector<Geo> data(num);
+
+    std::printf("[extrapolate]\n");
+    bench::measure("extrapolate (quadratic, obj.data attached)", count * num, [&] {
+        for (std::size_t i = 0; i < count; ++i)
+            for (int idx = 0; idx < num; ++idx) {
+                const Context context("bench", 640.0, 360.0, 0.0, 0.0, 0, idx, num, 0, 100);
+                Flow flow(Transform(), Transform(), make_geo(0), &data[idx]);
+                extrapolate(atlas, param, context, flow);
+                bench::keep(flow.geo.prev);
+            }
+    });
+}
+
+// One compute_motion worth of cache traffic in Full mode.
+static void
+step(AtlasOct &atlas, int id, int idx, int num, int frame) {
+    atlas.resize(id, idx, num, 1);
+    atlas.overwrite(id, idx, frame + 1, make_geo(frame));
+    bench::keep(atlas.read(id, idx, frame));
+}
+
+static void
+run_atlas(std::mt19937 &rng) {
+    std::printf("[atlas]\n");
+
+    {
+        constexpr int ids = 256, num = 8, frames = 256;
+        bench::measure("sequential render (256 ids x 8 idx)", ids * num * frames, [&] {
+            AtlasOct atlas;
+            for (int frame = 0; frame < frames; ++frame)
+                for (int id = 0; id < ids; ++id)
+                    for (int idx = 0; idx < num; ++idx) step(atlas, id, idx, num, frame);
+        });
+    }
+
+    {
+        constexpr int ids = 64, num = 8, frames = 4096;
+        AtlasOct atlas;
+        for (int frame = 0; frame < frames; ++frame)
+            for (int id = 0; id < ids; ++id)
+                for (int idx = 0; idx < num; ++idx) step(atlas, id, idx, num, frame);
+
+        std::vector<int> seek(count);
+        for (auto &f : seek) f = static_cast<int>(rng() % frames);
+
+        bench::measure("random scrubbing (64 ids x 8 idx, 4096 frames)", count * ids * num, [&] {
+            for (const int frame : seek)
+                for (int id = 0; id < ids; ++id)
+                    for (int idx = 0; idx < num; ++idx) step(atlas, id, idx, num, frame);
+        });
+    }
+
+    {
+        constexpr int ids = 16384, frames = 16;
+        bench::measure("many object ids (16384 ids x 1 idx)", ids * frames, [&] {
+            AtlasOct atlas;
+            for (int frame = 0; frame < frames; ++frame)
+                for (int id = 0; id < ids; ++id) step(atlas, id, 0, 1, frame);
+        });
+    }
+
+    {
+        constexpr int num = 50000, frames = 8;
+        bench::measure("large obj.num (1 id x 50000 idx)", num * frames, [&] {
+            AtlasOct atlas;
+            for (int frame = 0; frame < frames; ++frame)
+                for (int idx = 0; idx < num; ++idx) step(atlas, 0, idx, num, frame);
+        });
+    }
+
+    {
+        constexpr int ids = 1024, num = 4, frames = 64;
+        AtlasOct atlas;
+        bench::measure("fill then clear(id) (1024 ids x 4 idx x 64 frames)", ids, [&] {
+            for (int frame = 0; frame < frames; ++frame)
+                for (int id = 0; id < ids; ++id)
+                    for (int idx = 0; idx < num; ++idx) step(atlas, id, idx, num, frame);
+            for (int id = 0; id < ids; ++id) atlas.clear(id);
+        });
+    }
+}
+
+// Per-character text: one compute_motion per index against one compute_motion_batch for the whole id.
+static bool
+run_batch(std::mt19937 &rng) {
+    constexpr int num = 2048, frames = 4;
+    std::uniform_real_distribution<double> ofs(-40.0, 40.0);
+
+    std::vector<std::vector<Call>> calls(frames);
+    for (int frame = 0; frame < frames; ++frame) {
+        const double t = static_cast<double>(frame);
+        for (int idx = 0; idx < num; ++idx) {
+            const Transform curr(0.0, 0.0, t * 12.0, 0.0, t * 3.0, 1.0, 1.0);
+            const Transform prev(0.0, 0.0, (t - 1.0) * 12.0, 0.0, (t - 1.0) * 3.0, 1.0, 1.0);
+            calls[frame].push_back({Param(0.5, 256, 0.0, 1.0, false, 2, 1, 0, 0.0, 0, 0, false),
+                                    Context("bench", 24.0, 32.0, ofs(rng), ofs(rng), 0, idx, num, frame, frames),
+                                    {curr, prev},
+                                    Geo(frame, 0.0, 0.0, idx * 24.0 - num * 12.0, ofs(rng) * t, t, 1.0, 1.0),
+                                    std::nullopt});
+        }
+    }
+
+    std::vector<int> single, batch;
+    Host host;
+
+    std::printf("[batch] %d indices\n", num);
+    bench::measure("compute_motion per index", num * frames, [&] {
+        GeoCache cache;
+        single.clear();
+        for (const auto &frame : calls)
+            for (const auto &call : frame) {
+                host.clear();
+                host.push_call(call, nullptr);
+                script::compute_motion(&host, cache, [](const Call &, const Result &) {});
+                single.push_back(host.result().ints.front());
+            }
+    });
+    bench::measure("compute_motion_batch", num * frames, [&] {
+        GeoCache cache;
+        batch.clear();
+        for (const auto &frame : calls) {
+            host.clear();
+            host.push_batch(frame);
+            script::compute_motion_batch(&host, cache, [](const Call &, const Result &) {});
+            const auto &smp = host.result().int_arrays.front();
+            batch.insert(batch.end(), smp.begin(), smp.end());
+        }
+    });
+
+    const bool same = single == batch;
+    std::printf("samples: %s\n", same ? "identical" : "MISMATCH");
+    return same;
+}
+
+// Preview Budget over a preview whose motion swells and fades: per-frame cost of samples x pixels with and without
+// it. The cut lags a frame, so only frames after the first are held to the budget. Objects start at different offsets
+// on the timeline, so only the tick is shared by the objects of one frame.
+static bool
+run_budget() {
+    constexpr int ids = 48, frames = 120;
+    constexpr double budget = 40.0;
+
+    auto cost = [&](GeoCache &cache, double smp_budget, std::vector<double> &per_frame, std::vector<int> &smp) {
+        per_frame.assign(frames, 0.0);
+        smp.clear();
+        for (int frame = 0; frame < frames; ++frame) {
+            const double t = static_cast<double>(frame);
+            const double speed = 1.0 + std::sin(t * 0.05) * std::sin(t * 0.05) * 30.0;
+            for (int id = 0; id < ids; ++id) {
+                const double w = 64.0 + (id % 6) * 96.0, h = 48.0 + (id % 4) * 64.0;
+                const double v = speed * (1.0 + id % 5);
+                const int start = (id % 4) * 13;
+                const Context context("bench budget", w, h, 0.0, 0.0, id, 0, 1, frame + start, frames + start, frame);
+                Flow flow(Transform(0.0, 0.0, t * v, 0.0, t * (id % 3), 1.0, 1.0),
+                          Transform(0.0, 0.0, (t - 1.0) * v, 0.0, (t - 1.0) * (id % 3), 1.0, 1.0),
+                          Geo(frame, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0, 1.0), nullptr);
+
+                const Param param(0.5, 256, smp_budget, 1.0, false, 2, 0, 0, 0.0, 0, 0, false);
+                const auto result = compute(cache, param, context, flow);
+                const auto canvas = context.res + result.margin[0] + result.margin[1];
+                if (result.smp)
+                    per_frame[frame] += (result.smp + 1) * canvas.x() * canvas.y() * 1.0e-6;
+                smp.push_back(result.smp);
+            }
+        }
+    };
+
+    std::vector<double> free_cost, held_cost;
+    std::vector<int> free_smp, held_smp;
+    {
+        GeoCache cache;
+        cost(cache, 0.0, free_cost, free_smp);
+    }
+    GeoCache cache;
+    bench::measure("compute under Preview Budget", ids * frames, [&] { cost(cache, budget, held_cost, held_smp); });
+
+    // Within a frame, an object asking for more never ends up with fewer samples, nor with a smaller share of them
+    // but for rounding up. The share of the largest and smallest thirds of the requests is compared where any is cut.
+    bool ordered = true;
+    double large = 0.0, small = 0.0;
+    int cut = 0;
+    for (int frame = 1; frame < frames; ++frame) {
+        auto share = [&](int a) {
+            const std::size_t i = frame * ids + a;
+            return (held_smp[i] + 1.0) / (free_smp[i] + 1.0);
+        };
+
+        for (int a = 0; a < ids; ++a)
+            for (int b = 0; b < ids; ++b) {
+                const std::size_t i = frame * ids + a, j = frame * ids + b;
+                ordered &= free_smp[i] <= free_smp[j] || held_smp[i] >= held_smp[j];
+                ordered &= free_smp[i] <= free_smp[j] || held_smp[j] + 1 <= Governor::floor ||
+                           share(a) + 1.0 / (free_smp[j] + 1.0) >= share(b);
+            }
+
+        std::vector<int> order(ids);
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::sort(order, {}, [&](int a) { return free_smp[frame * ids + a]; });
+        if (std::ranges::all_of(order, [&](int a) { return share(a) == 1.0; }))
+            continue;
+
+        double lo = 0.0, hi = 0.0;
+        for (int k = 0; k < ids / 3; ++k) {
+            lo += share(order[k]);
+            hi += share(order[ids - 1 - k]);
+        }
+        small += lo / (ids / 3);
+        large += hi / (ids / 3);
+        ++cut;
+    }
+
+    double free_max = 0.0, held_max = 0.0, held_sum = 0.0;
+    int over = 0;
+    for (int frame = 1; frame < frames; ++frame) {
+        free_max = std::max(free_max, free_cost[frame]);
+        held_max = std::max(held_max, held_cost[frame]);
+        held_sum += held_cost[frame];
+        over += held_cost[frame] > budget * 1.1;
+    }
+
+    std::printf("[budget] %d objects, %.0f M samples x px per frame\n", ids, budget);
+    std::printf("cost per frame: max %.1f M without, max %.1f M / mean %.1f M with, %d of %d frames > 110%%\n",
+                free_max, held_max, held_sum / (frames - 1), over, frames - 1);
+    std::printf("samples kept over %d cut frames: %.0f%% by the largest third of requests, %.0f%% by the smallest\n", cut,
+                cut ? large / cut * 100.0 : 100.0, cut ? small / cut * 100.0 : 100.0);
+
+    const bool ok = ordered && over <= frames / 20 && free_max > budget && cut > 0 && large > small;
+    std::printf("budget: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Unrounded margins of the object box at the given fractions of the motion, each from the closed form of its map.
+static Mat2<double>
+sample_box(const Context &context, const Delta &delta, const std::vector<double> &amts) {
+    const auto half = context.res * 0.5;
+    auto lo = -half, hi = half;
+    for (const double a : amts) {
+        const auto m = delta.build_xform(a);
+        const auto xform = m.xform * m.scale;
+        for (int c = 0; c < 4; ++c) {
+            const Vec2<double> corner(c & 1 ? half.x() : -half.x(), c & 2 ? half.y() : -half.y());
+            const auto pt = (xform * (Vec3<double>(corner - context.pivot, 1.0) + m.drift)).to_vec2() + context.pivot;
+            lo = lo.min(pt);
+            hi = hi.max(pt);
+        }
+    }
+
+    Mat2<double> margin{};
+    margin[0] = -half - lo;
+    margin[1] = hi - half;
+    return margin;
+}
+
+// Longest corner path from dense closed-form samples of the maps.
+static double
+sample_travel(const Context &context, const Delta &delta, double amt, int dense) {
+    const auto half = context.res * 0.5;
+    double longest = 0.0;
+    for (int c = 0; c < 4; ++c) {
+        const Vec2<double> corner(c & 1 ? half.x() : -half.x(), c & 2 ? half.y() : -half.y());
+        auto prev = corner;
+        double len = 0.0;
+        for (int i = 1; i <= dense; ++i) {
+            const auto m = delta.build_xform(amt * i / dense);
+            const auto pt = ((m.xform * m.scale) * (Vec3<double>(corner - context.pivot, 1.0) + m.drift)).to_vec2() +
+                            context.pivot;
+            len += (pt - prev).norm<2>();
+            prev = pt;
+        }
+        longest = std::max(longest, len);
+    }
+    return longest;
+}
+
+// max_travel() against a dense oracle over random motions, and against the count from the margins it replaced on
+// per-frame motions. Those overestimate rotation about the pivot and scaling up, so max_travel may never ask for more
+// there; elsewhere the margins miss turns and inward motion, which leaves the taps far apart.
+static bool
+run_travel(std::mt19937 &rng) {
+    constexpr int cases = 1000, dense = 20000;
+    const auto from = make_xforms(rng);
+    const auto to = make_xforms(rng);
+    const Context context("bench", 640.0, 360.0, 12.0, -8.0, 0, 0, 1, 1, 100);
+
+    int off = 0;
+    for (int i = 0; i < cases; ++i) {
+        const Delta delta(from[i], to[i]);
+        const double travel = max_travel(context, delta, 0.5), oracle = sample_travel(context, delta, 0.5, dense);
+        off += std::abs(travel - oracle) > oracle * 1.0e-3 + 1.0 / 16.0;
+    }
+
+    std::uniform_real_distribution<double> move(-40.0, 40.0), turn(-8.0, 8.0), grow(0.92, 1.08), up(1.0, 1.1);
+    double by_margin = 0.0, by_travel = 0.0;
+    int named = 0, above = 0, gapped = 0;
+    for (int i = 0; i < cases * 4; ++i) {
+        const auto &a = from[i % from.size()];
+        Transform b(a[0], a[1], a[2] + move(rng), a[3] + move(rng), a[4] + turn(rng), a[5] * grow(rng),
+                    a[6] * grow(rng));
+        const int kind = i % 4;
+        if (kind == 1)
+            b = Transform(a[0], a[1], a[2], a[3], a[4] + turn(rng), a[5], a[6]);
+        else if (kind == 2)
+            b = Transform(a[0], a[1], a[2], a[3], a[4], a[5] * up(rng), a[6] * up(rng));
+
+        const Delta delta(a, b);
+        const auto margin = resize(context, delta, 0.5);
+        const double old = std::ceil((margin[0] + margin[1]).norm<2>()), travel = max_travel(context, delta, 0.5);
+        by_margin += old;
+        by_travel += std::ceil(travel);
+        above += std::ceil(travel) > old;
+        named += (kind == 1 || kind == 2) && std::ceil(travel) > old;
+        gapped += travel > std::max(old, 1.0) * 2.0;
+    }
+
+    std::printf("[travel] %d random motions against an oracle of %d samples, %d per-frame motions\n", cases, dense,
+                cases * 4);
+    std::printf("off the oracle: %d; per-frame mean required samples: margin %.1f, travel %.1f\n", off,
+                by_margin / (cases * 4), by_travel / (cases * 4));
+    std::printf("travel above margin: %d, of them rotation or scaling up: %d; margin taps > 2 px apart: %d\n", above,
+                named, gapped);
+
+    const bool ok = off == 0 && named == 0 && by_travel <= by_margin;
+    std::printf("travel: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// resize() against a dense-sampling oracle over random motions: it may never fall inside the swept box, nor exceed
+// it by more than the pixel that rounding up costs. The two-point estimate it replaced is counted for comparison.
+static bool
+run_resize(std::mt19937 &rng) {
+    constexpr int cases = 2000, dense = 20000;
+    std::uniform_real_distribution<double> size(16.0, 800.0), ofs(-300.0, 300.0), amt_dist(0.1, 2.0);
+    const auto from = make_xforms(rng);
+    const auto to = make_xforms(rng);
+
+    std::vector<Context> contexts;
+    std::vector<double> amts;
+    for (int i = 0; i < cases; ++i) {
+        contexts.emplace_back("bench resize", size(rng), size(rng), ofs(rng), ofs(rng), 0, 0, 1, 1, 2);
+        amts.push_back(amt_dist(rng));
+    }
+
+    std::vector<Mat2<double>> margins(cases);
+    bench::measure("resize", cases, [&] {
+        for (int i = 0; i < cases; ++i) margins[i] = resize(contexts[i], Delta(to[i], from[i]), amts[i]);
+    });
+
+    int clipped = 0, loose = 0, clipped_before = 0;
+    double area = 0.0, area_oracle = 0.0;
+    for (int i = 0; i < cases; ++i) {
+        const Delta delta(to[i], from[i]);
+        std::vector<double> fractions(dense + 1);
+        for (int k = 0; k <= dense; ++k) fractions[k] = amts[i] * k / dense;
+
+        const auto oracle = sample_box(contexts[i], delta, fractions);
+        const auto before = sample_box(contexts[i], delta, {amts[i] * 0.5, amts[i]});
+
+        bool clip = false, over = false, clip_before = false;
+        for (int side = 0; side < 2; ++side)
+            for (int j = 0; j < 2; ++j) {
+                clip |= margins[i][side][j] < oracle[side][j] - 1.0e-6;
+                over |= margins[i][side][j] > std::ceil(oracle[side][j] + 1.0 / 16.0 + 1.0e-6);
+                clip_before |= std::ceil(before[side][j]) < oracle[side][j] - 1.0e-6;
+            }
+        clipped += clip;
+        loose += over;
+        clipped_before += clip_before;
+
+        const auto canvas = contexts[i].res + margins[i][0] + margins[i][1];
+        const auto tight = contexts[i].res + oracle[0] + oracle[1];
+        area += canvas.x() * canvas.y();
+        area_oracle += tight.x() * tight.y();
+    }
+
+    std::printf("[resize] %d motions, oracle of %d samples\n", cases, dense);
+    std::printf("clipped: %d (two-point estimate: %d), looser than 1 px: %d, canvas %.4fx the swept box\n", clipped,
+                clipped_before, loose, area / area_oracle);
+
+    const bool ok = clipped == 0 && loose == 0;
+    std::printf("resize: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int
+main() {
+    std::mt19937 rng(42);
+    run_delta(rng);
+    run_extrapolate();
+    run_atlas(rng);
+    const bool batch = run_batch(rng);
+    const bool budget = run_budget();
+    const bool fit = run_resize(rng);
+    const bool travel = run_travel(rng);
+    return batch && budget && fit && travel ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "host.hpp"
+#include "motion.hpp"
+#include "script.hpp"
+#include "trace.hpp"
+
+// Replays a trace recorded with OBJECTMOTIONBLUR_LK_TRACE. Without an argument, a synthetic project is recorded
+// through the host stand-in first.
+static std::string
+synthesize() {
+    constexpr int ids = 32, num = 16, frames = 240;
+    const auto path = (std::filesystem::temp_directory_path() / "ObjectMotionBlur_LK.synthetic.trace").string();
+
+    trace::Writer writer(path);
+    GeoCache cache;
+    Host host;
+    std::vector<Geo> data(static_cast<std::size_t>(ids) * num);
+
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int id = 0; id < ids; ++id) {
+            for (int idx = 0; idx < num; ++idx) {
+                const double t = static_cast<double>(frame);
+                const double k = static_cast<double>(id * num + idx);
+                auto xform = [&](double s) {
+                    return Transform(0.0, 0.0, std::cos(s * 0.05 + k) * 400.0, std::sin(s * 0.03) * 200.0,
+                                     s * (id % 4) * 3.0, 100.0 + std::sin(s * 0.1) * 20.0, 100.0);
+                };
+
+                const Call call{Param(0.5, 256, 0.0, 1.0, id % 2, 2, id % 3, 0, 0.0, 0, 0, false),
+                                Context("synthetic", 320.0, 180.0, 0.0, 0.0, id, idx, num, frame, frames),
+                                {xform(t), xform(t - 1.0)},
+                                Geo(frame, 0.0, 0.0, std::sin(t * 0.2 + k) * 30.0, 0.0, t, 1.0, 1.0),
+                                std::nullopt};
+
+                host.clear();
+                host.push_call(call, &data[id * num + idx]);
+                script::compute_motion(&host, cache, [&](const Call &c, const Result &) { writer.write(c); });
+            }
+        }
+    }
+
+    return path;
+}
+
+int
+main(int argc, char **argv) {
+    const std::string path = argc > 1 ? argv[1] : synthesize();
+
+    trace::Reader reader(path);
+    if (!reader.is_open()) {
+        std::fprintf(stderr, "Cannot open trace: %s\n", path.c_str());
+        return 1;
+    }
+
+    const auto calls = reader.read_all();
+    std::printf("trace: %s (%zu calls)\n", path.c_str(), calls.size());
+    if (calls.empty())
+        return 0;
+
+    std::vector<Geo> data(calls.size());
+    auto reset = [&] {
+        for (std::size_t i = 0; i < calls.size(); ++i) data[i] = calls[i].data.value_or(Geo());
+    };
+
+    long long smp_core = 0, smp_host = 0;
+
+    const auto core = bench::measure("replay: core (compute)", calls.size(), [&] {
+        GeoCache cache;
+        reset();
+        smp_core = 0;
+        for (std::size_t i = 0; i < calls.size(); ++i) {
+            const auto &call = calls[i];
+            Flow flow(call.xform.curr, call.xform.prev, call.geo, call.data ? &data[i] : nullptr);
+            smp_core += compute(cache, call.param, call.context, flow).smp + 1;
+        }
+    });
+
+    Host host;
+    const auto full = bench::measure("replay: script marshalling + core", calls.size(), [&] {
+        GeoCache cache;
+        reset();
+        smp_host = 0;
+        for (std::size_t i = 0; i < calls.size(); ++i) {
+            host.clear();
+            host.push_call(calls[i], calls[i].data ? &data[i] : nullptr);
+            script::compute_motion(&host, cache, [](const Call &, const Result &) {});
+            smp_host += host.result().ints.empty() ? 0 : host.result().ints.front();
+        }
+    });
+
+    // The script's path: xform_prev from the module, and from the trace only when the module does not have it.
+    long long smp_cached = 0;
+    std::size_t misses = 0;
+    const auto cached = bench::measure("replay: script with cached xform_prev", calls.size(), [&] {
+        GeoCache cache;
+        reset();
+        smp_cached = 0;
+        misses = 0;
+        for (std::size_t i = 0; i < calls.size(); ++i) {
+            Geo *ptr = calls[i].data ? &data[i] : nullptr;
+            host.clear();
+            host.push_call(calls[i], ptr, true);
+            script::compute_motion(&host, cache, [](const Call &, const Result &) {});
+            if (host.result().ints.empty()) {
+                ++misses;
+                host.clear();
+                host.push_call(calls[i], ptr);
+                script::compute_motion(&host, cache, [](const Call &, const Result &) {});
+            }
+            smp_cached += host.result().ints.empty() ? 0 : host.result().ints.front();
+        }
+    });
+
+    // Scrubbing back and forth over the first quarter of the timeline: the second pass stores the results, later ones
+    // are served from them. Both see the same warm geo cache, so they must agree.
+    const std::size_t window = calls.size() / 16;
+    long long smp_scrub = 0;
+    GeoCache plain, scrubbed;
+    plain.memo().set_capacity(0);
+    auto scrub = [&](GeoCache &target) {
+        reset();
+        smp_scrub = 0;
+        for (std::size_t i = 0; i < window; ++i) {
+            const auto &call = calls[i];
+            Flow flow(call.xform.curr, call.xform.prev, call.geo, call.data ? &data[i] : nullptr);
+            smp_scrub += compute(target, call.param, call.context, flow).smp + 1;
+        }
+    };
+    scrub(plain);
+    const auto warm = bench::measure("replay: core over the warm window", window, [&] { scrub(plain); });
+    const long long smp_warm = smp_scrub;
+    scrub(scrubbed);
+    scrub(scrubbed);
+    const auto memo = bench::measure("replay: core over memoized results", window, [&] { scrub(scrubbed); });
+    const auto counters = scrubbed.memo().counters();
+    std::printf("memo: %llu hits, %llu misses, %zu entries, %.1f MiB, %.1fx over the warm window\n",
+                static_cast<unsigned long long>(counters.hits), static_cast<unsigned long long>(counters.misses),
+                counters.entries, static_cast<double>(counters.bytes) / 1048576.0, warm.ns / memo.ns);
+
+    // Cache Purge All of one script drops the memoized results with its geos.
+    scrubbed.clear(calls.front().context.name);
+    const std::size_t purged = scrubbed.memo().counters().entries;
+    std::printf("memo after purging %s: %zu entries\n", calls.front().context.name.c_str(), purged);
+
+    std::printf("throughput: core %.0f calls/s, full %.0f calls/s, cached %.0f calls/s, memoized %.0f calls/s\n",
+                1.0e9 / core.ns, 1.0e9 / full.ns, 1.0e9 / cached.ns, 1.0e9 / memo.ns);
+    std::printf("xform_prev from the module on %.1f%% of calls\n",
+                100.0 * static_cast<double>(calls.size() - misses) / static_cast<double>(calls.size()));
+
+    // The stats function over one more pass must count every call and agree with the samples delivered, which neither
+    // the limits nor the rounding of doubling take past those requested.
+    GeoCache cache;
+    reset();
+    for (std::size_t i = 0; i < calls.size(); ++i) {
+        host.clear();
+        host.push_call(calls[i], calls[i].data ? &data[i] : nullptr);
+        script::compute_motion(&host, cache, [](const Call &, const Result &) {});
+    }
+    host.clear();
+    script::stats(&host, cache);
+    auto stat = [&](std::string_view key) {
+        for (const auto &[k, v] : host.result().table)
+            if (k == key)
+                return v;
+        return -1.0;
+    };
+    std::printf("stats: %.0f calls, p50 %.1f us, p99 %.1f us, hit rate %.3f, clamped %.0f, %.0f of %.0f samples\n",
+                stat("calls"), stat("latency_p50_us"), stat("latency_p99_us"), stat("hit_rate"), stat("clamped"),
+                stat("delivered_samples"), stat("requested_samples"));
+    std::printf("memo: %.0f hits, %.0f misses, %.0f entries, %.0f B\n", stat("memo_hits"), stat("memo_misses"),
+                stat("memo_entries"), stat("memo_bytes"));
+    const bool stats_ok = stat("calls") == static_cast<double>(calls.size()) &&
+                          stat("delivered_samples") == static_cast<double>(smp_host) &&
+                          stat("requested_samples") > 0.0 &&
+                          stat("delivered_samples") <= stat("requested_samples");
+
+    const bool ok = smp_core == smp_host && smp_core == smp_cached && smp_warm == smp_scrub && stats_ok && !purged;
+    std::printf("delivered samples: core %lld, full %lld, cached %lld; warm window %lld, memoized %lld%s\n", smp_core,
+                smp_host, smp_cached, smp_warm, smp_scrub, ok ? "" : " (MISMATCH)");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "cache.hpp"
+#include "motion.hpp"
+#include "store.hpp"
+#include "structs.hpp"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Persistent geo cache: a render resumed halfway through from the files of an earlier session must match that
+// session, where a cold in-memory cache does not. Resuming is timed against replaying the timeline from frame 0.
+constexpr int ids = 32, num = 8, frames = 240, half = frames / 2;
+
+static double
+step(GeoCache &cache, const std::string &scene, int id, int idx, int frame) {
+    const Param param(0.5, 256, 0.0, 1.0, false, 2, 1, 0, 0.0, 0, 0, false);
+    const double t = static_cast<double>(frame);
+    const Context context("bench store", 200.0, 100.0, 0.0, 0.0, id, idx, num, frame, frames, 0, scene);
+    Flow flow(Transform(0.0, 0.0, std::cos(t * 0.05 + id) * 300.0, 0.0, 0.0, 100.0, 100.0),
+              Transform(0.0, 0.0, std::cos((t - 1.0) * 0.05 + id) * 300.0, 0.0, 0.0, 100.0, 100.0),
+              Geo(frame, 0.0, 0.0, std::sin(t * 0.3 + idx) * 40.0, idx * 4.0, t * (id % 3), 1.0, 1.0), nullptr);
+
+    const auto result = compute(cache, param, context, flow);
+    return result.smp + result.margin[0].x() + result.margin[1].y();
+}
+
+// Checksum of frames [half, frames) of scene after rendering [first, frames).
+static double
+render(GeoCache &cache, int first, const std::string &scene = "bench|1") {
+    double sum = 0.0;
+    for (int frame = first; frame < frames; ++frame)
+        for (int id = 0; id < ids; ++id)
+            for (int idx = 0; idx < num; ++idx) {
+                const double v = step(cache, scene, id, idx, frame);
+                if (frame >= half)
+                    sum += v;
+            }
+
+    return sum;
+}
+
+// Layout survives a change of num without moving a block, and reuses the blocks of indices cut off; a file of
+// another version, scene or id starts over.
+static bool
+check_file(const std::filesystem::path &dir) {
+    const auto path = dir / "layout.geo";
+    constexpr std::uint64_t key = 0x5eed;
+    const Geo a(1, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0), b(9, 9.0, 8.0, 7.0, 6.0, 5.0, 4.0, 3.0);
+    bool ok = true;
+    std::size_t blocks = 0;
+    {
+        GeoFile file(path, 7, key, 4);
+        file.write(1, 3, a);
+        file.write(3, 500, b);
+        blocks = file.blocks();
+        ok &= file.is_open() && blocks >= 2;
+    }
+    const auto bytes = std::filesystem::file_size(path);
+    {
+        GeoFile file(path, 7, key, 6);
+        ok &= file.read(1, 3) && (*file.read(1, 3))[6] == 7.0 && file.read(3, 500) && !file.read(5, 500);
+        file.resize(2);
+        file.resize(4);
+        ok &= file.read(1, 3) && !file.read(3, 500);
+        file.write(2, 900, b);
+        ok &= file.read(2, 900) && file.blocks() == blocks;
+    }
+    ok &= std::filesystem::file_size(path) == bytes;
+    {
+        GeoFile file(path, 7, key, 2);
+        ok &= file.read(1, 3) && !file.read(2, 900);
+    }
+    {
+        GeoFile file(path, 7, key + 1, 2);
+        ok &= file.is_open() && !file.read(1, 3);
+        file.write(1, 3, a);
+    }
+    {
+        GeoFile file(path, 8, key + 1, 2);
+        ok &= file.is_open() && !file.read(1, 3);
+        file.write(1, 3, a);
+    }
+    {
+        std::fstream raw(path, std::ios::in | std::ios::out | std::ios::binary);
+        raw.seekp(4);
+        const std::uint32_t ver = GeoFile::version + 1;
+        raw.write(reinterpret_cast<const char *>(&ver), sizeof(ver));
+    }
+    {
+        GeoFile file(path, 8, key + 1, 2);
+        ok &= file.is_open() && !file.read(1, 3);
+    }
+    return ok;
+}
+
+// A grow the file system refuses drops that write only: the file stays mapped with its history. Needs a file size
+// limit to refuse it, so POSIX only.
+static bool
+check_grow(const std::filesystem::path &dir) {
+#ifdef _WIN32
+    return true;
+#else
+    const auto path = dir / "grow.geo";
+    const Geo a(1, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+    GeoFile file(path, 1, 1, 1);
+    for (int pos = 0; pos < GeoFile::block * 4; pos += GeoFile::block) file.write(0, pos, a);
+
+    const std::size_t blocks = file.blocks();
+    rlimit old{};
+    ::getrlimit(RLIMIT_FSIZE, &old);
+    const auto saved = std::signal(SIGXFSZ, SIG_IGN);
+    rlimit cap = old;
+    cap.rlim_cur = static_cast<rlim_t>(std::filesystem::file_size(path));
+    ::setrlimit(RLIMIT_FSIZE, &cap);
+
+    file.write(0, GeoFile::block * 64, a);
+
+    ::setrlimit(RLIMIT_FSIZE, &old);
+    std::signal(SIGXFSZ, saved);
+
+    bool ok = file.is_open() && file.blocks() == blocks && !file.read(0, GeoFile::block * 64);
+    for (int pos = 0; pos < GeoFile::block * 4; pos += GeoFile::block) ok &= file.read(0, pos) != nullptr;
+
+    file.write(0, GeoFile::block * 64, a);
+    return ok && file.read(0, GeoFile::block * 64);
+#endif
+}
+
+int
+main() {
+    const auto dir = std::filesystem::temp_directory_path() / "ObjectMotionBlur_LK.bench_store";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    const bool file_ok = check_file(dir);
+    std::printf("file layout: %s\n", file_ok ? "ok" : "FAILED");
+
+    const bool grow_ok = check_grow(dir);
+    std::printf("failed grow: %s\n", grow_ok ? "ok" : "FAILED");
+
+    double reference = 0.0;
+    {
+        GeoCache cache;
+        cache.persist(dir);
+        reference = render(cache, 0);
+    }
+
+    // Each shard clears its own directory whole, so no two shards may share one. Ids below shards each get their own.
+    std::set<std::filesystem::path> folders;
+    std::size_t files = 0;
+    for (const auto &f : std::filesystem::recursive_directory_iterator(dir)) {
+        if (f.path().extension() == ".geo" && f.path().parent_path() != dir) {
+            folders.insert(f.path().parent_path());
+            ++files;
+        }
+    }
+    const bool shard_ok = files == ids && folders.size() == ids;
+    std::printf("shard directories: %zu for %zu files: %s\n", folders.size(), files, shard_ok ? "ok" : "SHARED");
+
+    double resumed = 0.0, cold = 0.0, other = 0.0;
+    const std::size_t calls = static_cast<std::size_t>(frames - half) * ids * num;
+    std::printf("[resume] %d ids x %d idx from frame %d of %d, Full\n", ids, num, half, frames);
+    const auto disk = bench::measure("resume: persisted cache", calls, [&] {
+        GeoCache cache;
+        cache.persist(dir);
+        resumed = render(cache, half);
+    });
+    bench::measure("resume: cold in-memory cache (wrong blur)", calls, [&] {
+        GeoCache cache;
+        cold = render(cache, half);
+    });
+    const auto replay = bench::measure("replay: in-memory cache from frame 0", calls, [&] {
+        GeoCache cache;
+        bench::keep(render(cache, 0));
+    });
+
+    // Same ids in another project or scene, where the files of the first must not be read.
+    {
+        GeoCache cache;
+        cache.persist(dir);
+        other = render(cache, half, "bench|2");
+    }
+
+    std::printf("resume saves %.1fx over replay\n", replay.ns / disk.ns);
+    std::printf("checksum: reference %.1f, persisted %.1f, cold %.1f, other scene %.1f\n", reference, resumed, cold,
+                other);
+
+    std::filesystem::remove_all(dir);
+
+    const bool ok = file_ok && grow_ok && shard_ok && resumed == reference && cold != reference && other == cold;
+    std::printf("resume: %s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
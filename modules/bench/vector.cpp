@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <execution>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+#include "bench.hpp"
+#include "vector/vector.hpp"
+
+// Generic implementations preceding the fixed-size backend, kept for comparison.
+namespace legacy {
+template <typename M>
+static M
+mul(const M &a, const M &b) noexcept {
+    constexpr std::size_t n = M::size() == 4 ? 2 : 3;
+    constexpr auto idx = std::views::iota(std::size_t{0}, n);
+
+    M result;
+    std::for_each(std::execution::par_unseq, idx.begin(), idx.end(), [&](std::size_t k) {
+        const auto &vec = b[k];
+        for (std::size_t j = 0; j < n; ++j) {
+            const double &v = vec[j];
+            for (std::size_t i = 0; i < n; ++i) {
+                result[k][i] += a[j][i] * v;
+            }
+        }
+    });
+    return result;
+}
+
+template <typename M, typename V>
+static V
+mul_vec(const M &a, const V &vec) noexcept {
+    V result;
+    for (std::size_t j = 0; j < V::size(); ++j) {
+        const double &v = vec[j];
+        for (std::size_t i = 0; i < V::size(); ++i) {
+            result[i] += a[j][i] * v;
+        }
+    }
+    return result;
+}
+
+template <typename V>
+static double
+norm(const V &vec, int ord = 2) {
+    switch (ord) {
+        case 1: {
+            double sum = 0.0;
+            for (std::size_t i = 0; i < V::size(); ++i) sum += std::abs(vec[i]);
+            return sum;
+        }
+        case 2: {
+            double sum = 0.0;
+            for (std::size_t i = 0; i < V::size(); ++i) sum += vec[i] * vec[i];
+            return std::sqrt(sum);
+        }
+        default:
+            throw std::invalid_argument("unsupported norm");
+    }
+}
+}  // namespace legacy
+
+constexpr std::size_t count = 1 << 12;
+constexpr std::size_t rounds = 256;
+constexpr std::size_t ops = count * rounds;
+
+template <typename V>
+static std::vector<V>
+make_vecs(std::mt19937 &rng) {
+    std::uniform_real_distribution<double> dist(-2.0, 2.0);
+    std::vector<V> vecs(count);
+    for (auto &v : vecs)
+        for (std::size_t i = 0; i < V::size(); ++i) v[i] = dist(rng);
+    return vecs;
+}
+
+template <typename M, typename V>
+static std::vector<M>
+make_mats(std::mt19937 &rng) {
+    std::vector<M> mats(count);
+    auto cols = make_vecs<V>(rng);
+    for (std::size_t k = 0; k < count; ++k)
+        for (std::size_t j = 0; j < V::size(); ++j) mats[k][j] = cols[(k + j) % count];
+    return mats;
+}
+
+template <typename M, typename V>
+static void
+run(const char *label, std::mt19937 &rng) {
+    const auto a = make_mats<M, V>(rng);
+    const auto b = make_mats<M, V>(rng);
+    const auto v = make_vecs<V>(rng);
+
+    std::printf("[%s]\n", label);
+
+    bench::measure("mat * mat (legacy par_unseq)", ops, [&] {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < count; ++i) bench::keep(legacy::mul(a[i], b[i]));
+    });
+    bench::measure("mat * mat (fixed-size)", ops, [&] {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < count; ++i) bench::keep(a[i] * b[i]);
+    });
+
+    bench::measure("mat * vec (legacy)", ops, [&] {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < count; ++i) bench::keep(legacy::mul_vec(a[i], v[i]));
+    });
+    bench::measure("mat * vec (fixed-size)", ops, [&] {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < count; ++i) bench::keep(a[i] * v[i]);
+    });
+
+    bench::measure("norm(2) (legacy runtime ord)", ops, [&] {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < count; ++i) bench::keep(legacy::norm(v[i], 2));
+    });
+    bench::measure("norm<2>() (fixed-size)", ops, [&] {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < count; ++i) bench::keep(v[i].template norm<2>());
+    });
+}
+
+int
+main() {
+    std::mt19937 rng(42);
+    std::printf("simd: sse2=%d avx2=%d\n", vector::simd::sse2, vector::simd::avx2);
+
+    run<Mat2<double>, Vec2<double>>("2x2", rng);
+    run<Mat3<double>, Vec3<double>>("3x3", rng);
+    return 0;
+}
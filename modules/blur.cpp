@@ -0,0 +1,1085 @@
+#include "blur.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <stdexcept>
+
+#include "motion.hpp"
+#include "pool.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using Color = std::array<float, 4>;
+
+static Color
+load(const Image &img, int x, int y) noexcept {
+    const auto *ptr = static_cast<const std::byte *>(img.data) + y * img.pitch + x * img.bpp();
+
+    if (img.depth == Depth::u8) {
+        const auto *c = reinterpret_cast<const std::uint8_t *>(ptr);
+        return {static_cast<float>(c[0]), static_cast<float>(c[1]), static_cast<float>(c[2]),
+                static_cast<float>(c[3])};
+    } else {
+        Color c;
+        std::memcpy(c.data(), ptr, sizeof(c));
+        return c;
+    }
+}
+
+static void
+store(const Image &img, int x, int y, const Color &c) noexcept {
+    auto *ptr = static_cast<std::byte *>(img.data) + y * img.pitch + x * img.bpp();
+
+    if (img.depth == Depth::u8) {
+        auto *dst = reinterpret_cast<std::uint8_t *>(ptr);
+        for (std::size_t i = 0; i < c.size(); ++i)
+            dst[i] = static_cast<std::uint8_t>(std::clamp(std::lrint(c[i]), 0l, 255l));
+    } else {
+        std::memcpy(ptr, c.data(), sizeof(c));
+    }
+}
+
+// Bilinear filter with a transparent border, in texel space.
+static Color
+sample(const Image &img, float u, float v) noexcept {
+    const float fx = std::floor(u);
+    const float fy = std::floor(v);
+
+    if (!(fx >= -1.0f && fx < static_cast<float>(img.w) && fy >= -1.0f && fy < static_cast<float>(img.h)))
+        return {};
+
+    const float wx = u - fx;
+    const float wy = v - fy;
+    const int x = static_cast<int>(fx);
+    const int y = static_cast<int>(fy);
+
+    auto fetch = [&](int i, int j) {
+        return i < 0 || j < 0 || i >= img.w || j >= img.h ? Color{} : load(img, i, j);
+    };
+
+    const Color c00 = fetch(x, y), c10 = fetch(x + 1, y), c01 = fetch(x, y + 1), c11 = fetch(x + 1, y + 1);
+    const float w00 = (1.0f - wx) * (1.0f - wy);
+    const float w10 = wx * (1.0f - wy);
+    const float w01 = (1.0f - wx) * wy;
+    const float w11 = wx * wy;
+
+    Color c;
+    for (std::size_t i = 0; i < c.size(); ++i) c[i] = c00[i] * w00 + c10[i] * w10 + c01[i] * w01 + c11[i] * w11;
+    return c;
+}
+
+// Average of n samples, then the unblurred pixel is mixed in behind it.
+static void
+finish(const Image &dst, int x, int y, Color col, const Color &base, int n, float mix) noexcept {
+    const float unit = dst.depth == Depth::u8 ? 1.0f / 255.0f : 1.0f;
+    const float rn = 1.0f / static_cast<float>(n);
+    for (auto &c : col) c *= rn;
+
+    const float a = 1.0f - col[3] * unit;
+    for (std::size_t i = 0; i < col.size(); ++i) col[i] += base[i] * a * mix;
+
+    store(dst, x, y, col);
+}
+
+// One resampled row and the sum of its texels in front of each, so that a box over any span costs two lookups. Texel a
+// covers [a - 0.5, a + 0.5); a closed row repeats every size texels, an open one is transparent outside.
+struct Sums {
+    std::vector<Color> texels, sums;
+    bool closed;
+
+    template <typename F>
+    Sums(int size, bool closed_, F &&fetch) : texels(std::max(size, 1)), sums(texels.size() + 1), closed(closed_) {
+        for (std::size_t a = 0; a < texels.size(); ++a) {
+            texels[a] = fetch(static_cast<int>(a));
+            for (std::size_t i = 0; i < 4; ++i) sums[a + 1][i] = sums[a][i] + texels[a][i];
+        }
+    }
+
+    [[nodiscard]] Color integral(double u) const noexcept {
+        const int size = static_cast<int>(texels.size());
+        double t = u + 0.5, turns = 0.0;
+        if (closed) {
+            turns = std::floor(t / size);
+            t -= turns * size;
+        }
+
+        const int a = std::min(static_cast<int>(std::floor(t)), size - 1);
+        if (a < 0)
+            return Color{};
+        if (!closed && t >= size)
+            return sums[size];
+
+        const auto f = static_cast<float>(t - a), k = static_cast<float>(turns);
+        Color c;
+        for (std::size_t i = 0; i < c.size(); ++i) c[i] = sums[size][i] * k + sums[a][i] + texels[a][i] * f;
+        return c;
+    }
+
+    // Mean over [lo, hi), which must not be empty.
+    [[nodiscard]] Color mean(double lo, double hi) const noexcept {
+        const Color a = integral(lo), b = integral(hi);
+        const auto r = static_cast<float>(1.0 / (hi - lo));
+        Color c;
+        for (std::size_t i = 0; i < c.size(); ++i) c[i] = (b[i] - a[i]) * r;
+        return c;
+    }
+};
+
+// Samples along a ray from the pivot, texel i covering radii [first + i, first + i + 1), integrated over log radius so
+// that a box of taps scaled by one factor costs two lookups. Transparent before first and beyond the end.
+struct LogSums {
+    std::vector<Color> texels, sums;
+    int first;
+
+    template <typename F>
+    LogSums(int first_, int size, F &&fetch) : texels(std::max(size, 1)), sums(texels.size() + 1), first(first_) {
+        for (std::size_t i = 0; i < texels.size(); ++i) {
+            const double m = first + static_cast<double>(i);
+            texels[i] = fetch(static_cast<int>(m));
+            const auto w = m > 0.0 ? static_cast<float>(std::log((m + 1.0) / m)) : 0.0f;
+            for (std::size_t c = 0; c < 4; ++c) sums[i + 1][c] = sums[i][c] + texels[i][c] * w;
+        }
+    }
+
+    // Up to rho from first, or from 1 when first is 0 and so negative inside the first texel. rho must be positive.
+    [[nodiscard]] Color integral(double rho) const noexcept {
+        if (rho < first)
+            return Color{};
+
+        const auto m = std::floor(rho);
+        const auto i = static_cast<std::size_t>(m - first);
+        if (i >= texels.size())
+            return sums.back();
+
+        const auto w = static_cast<float>(m > 0.0 ? std::log(rho / m) : std::log(rho));
+        Color c;
+        for (std::size_t k = 0; k < c.size(); ++k) c[k] = sums[i][k] + texels[i][k] * w;
+        return c;
+    }
+
+    // Mean over radii [lo, hi) weighted by 1 / rho, which must not be empty.
+    [[nodiscard]] Color mean(double lo, double hi) const noexcept {
+        const Color a = integral(lo), b = integral(hi);
+        const auto r = static_cast<float>(1.0 / std::log(hi / lo));
+        Color c;
+        for (std::size_t i = 0; i < c.size(); ++i) c[i] = (b[i] - a[i]) * r;
+        return c;
+    }
+};
+
+// Sum of n taps from the means of the two rows around a pixel, f of the way from the first to the second.
+static Color
+blend(const Color &m0, const Color &m1, float f, int n) noexcept {
+    Color c;
+    for (std::size_t i = 0; i < c.size(); ++i) c[i] = (m0[i] * (1.0f - f) + m1[i] * f) * static_cast<float>(n);
+    return c;
+}
+
+Blur::Blur(const Delta::Motion &motion, const Vec2<double> &pivot_, int n_, double mix_) :
+    pose{}, pivot{static_cast<float>(pivot_.x()), static_cast<float>(pivot_.y())}, taps(), n(std::max(n_, 1)),
+    mix(static_cast<float>(mix_)) {
+    const auto &m = motion.xform;
+    for (std::size_t i = 0; i < pose.size(); ++i) pose[i] = static_cast<float>(m(i % 2, i / 2));
+
+    const float sx = static_cast<float>(motion.scale[0]);
+    const float sy = static_cast<float>(motion.scale[1]);
+    const float dx = static_cast<float>(motion.drift.x());
+    const float dy = static_cast<float>(motion.drift.y());
+
+    // Unroll the per-tap state updates of the shader once; every pixel walks the same sequence.
+    Tap tap{static_cast<float>(m(0, 2)), static_cast<float>(m(1, 2)), sx, sy, dx, dy};
+    taps.reserve(n - 1);
+    for (int i = 1; i < n; ++i) {
+        taps.push_back(tap);
+
+        const float tx = pose[0] * tap.tx + pose[2] * tap.ty;
+        const float ty = pose[1] * tap.tx + pose[3] * tap.ty;
+        tap = {tx, ty, tap.sx * sx, tap.sy * sy, tap.dx + dx, tap.dy + dy};
+    }
+}
+
+void
+Blur::render(const Image &src, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    Pool::shared().run(src.h, [&](std::size_t y) { render_row(src, dst, static_cast<int>(y)); });
+}
+
+void
+Blur::render_row(const Image &src, const Image &dst, int y) const noexcept {
+    int x = 0;
+#if defined(__AVX2__)
+    for (; x + 8 <= src.w; x += 8) render_x8(src, dst, x, y);
+#endif
+    for (; x < src.w; ++x) render_px(src, dst, x, y);
+}
+
+void
+Blur::render_px(const Image &src, const Image &dst, int x, int y) const noexcept {
+    float px = (static_cast<float>(x) + 0.5f) - pivot[0];
+    float py = (static_cast<float>(y) + 0.5f) - pivot[1];
+
+    const Color base = load(src, x, y);
+    Color col = base;
+    for (const auto &tap : taps) {
+        const float qx = pose[0] * px + pose[2] * py + tap.tx;
+        const float qy = pose[1] * px + pose[3] * py + tap.ty;
+        px = qx;
+        py = qy;
+
+        const Color c = sample(src, tap.sx * px + tap.dx + pivot[0] - 0.5f, tap.sy * py + tap.dy + pivot[1] - 0.5f);
+        for (std::size_t i = 0; i < col.size(); ++i) col[i] += c[i];
+    }
+
+    finish(dst, x, y, col, base, n, mix);
+}
+
+// Column-major 2x3 maps from texels of the image to texels of a level of it 2^lod times smaller, where texel i covers
+// texels [i * 2^lod, (i + 1) * 2^lod). The move to pivot-relative texel centers and back is folded into the offsets, in
+// double: texel(q) = A * (texel(p) - c) + t + c with c = pivot - 0.5.
+static std::vector<std::array<float, 6>>
+fold_maps(const std::vector<double> &taps, const Vec2<double> &pivot, int lod) {
+    const double cx = pivot.x() - 0.5, cy = pivot.y() - 0.5;
+    const double s = std::ldexp(1.0, -lod), o = 0.5 * s - 0.5;
+
+    std::vector<std::array<float, 6>> maps;
+    maps.reserve(taps.size() / 6);
+    for (std::size_t i = 0; i + 6 <= taps.size(); i += 6) {
+        const double *m = &taps[i];
+        maps.push_back({static_cast<float>(m[0] * s), static_cast<float>(m[3] * s), static_cast<float>(m[1] * s),
+                        static_cast<float>(m[4] * s), static_cast<float>((m[2] + cx - (m[0] * cx + m[1] * cy)) * s + o),
+                        static_cast<float>((m[5] + cy - (m[3] * cx + m[4] * cy)) * s + o)});
+    }
+    return maps;
+}
+
+TableBlur::TableBlur(const std::vector<double> &taps, const Vec2<double> &pivot, double mix_, int lod,
+                     Precision precision_) :
+    maps(fold_maps(taps, pivot, lod)), n(static_cast<int>(maps.size()) + 1), mix(static_cast<float>(mix_)),
+    precision(precision_) {}
+
+void
+TableBlur::render(const Image &src, const Image &dst) const {
+    render(src, src, dst);
+}
+
+void
+TableBlur::render(const Image &src, const Image &level, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data || level.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    std::vector<std::uint16_t> half;
+#if defined(__AVX2__)
+    if (precision == Precision::f16) {
+        half.resize(static_cast<std::size_t>(level.w) * level.h * 4);
+        Pool::shared().run(level.h, [&](std::size_t y) {
+            auto *out = &half[y * level.w * 4];
+            for (int x = 0; x < level.w; ++x) {
+                const Color c = load(level, x, static_cast<int>(y));
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x * 4),
+                                 _mm_cvtps_ph(_mm_loadu_ps(c.data()), _MM_FROUND_TO_NEAREST_INT));
+            }
+        });
+    }
+#endif
+
+    Pool::shared().run(src.h, [&](std::size_t y) {
+        render_row(src, level, half.empty() ? nullptr : half.data(), dst, static_cast<int>(y), 0, src.w);
+    });
+}
+
+void
+TableBlur::render_rect(const Image &src, const Image &dst, int x0, int y0, int x1, int y1) const noexcept {
+    for (int y = y0; y < y1; ++y) render_row(src, src, nullptr, dst, y, x0, x1);
+}
+
+void
+TableBlur::render_row(const Image &src, const Image &level, const std::uint16_t *half, const Image &dst, int y, int x0,
+                      int x1) const noexcept {
+    int x = x0;
+#if defined(__AVX2__)
+    for (; x + 8 <= x1; x += 8) {
+        if (half)
+            render_x8_half(src, level, half, dst, x, y);
+        else if (precision == Precision::fixed8 && level.depth == Depth::u8)
+            render_x8_fixed(src, level, dst, x, y);
+        else
+            render_x8(src, level, dst, x, y);
+    }
+#else
+    static_cast<void>(half);
+#endif
+    for (; x < x1; ++x) render_px(src, level, dst, x, y);
+}
+
+LineBlur::LineBlur(const Delta::Motion &motion, int n_, double mix_) :
+    step(), slope(), transpose(), n(std::max(n_, 1)), mix(static_cast<float>(mix_)) {
+    // With an identity pose and scale, every tap adds the translation and the drift once more.
+    const double dx = motion.xform(0, 2) + motion.drift.x();
+    const double dy = motion.xform(1, 2) + motion.drift.y();
+
+    transpose = std::abs(dy) > std::abs(dx);
+    step = transpose ? dy : dx;
+    slope = step != 0.0 ? (transpose ? dx : dy) / step : 0.0;
+}
+
+void
+LineBlur::render(const Image &src, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    // Pixel (a, b) on the major and minor axes lies on sheared row b - a * slope; the corners bound them all.
+    const int w = transpose ? src.h : src.w, h = transpose ? src.w : src.h;
+    auto row = [&](int a, int b) { return static_cast<int>(std::floor(b - a * slope)); };
+    const int lo = std::min({row(0, 0), row(w - 1, 0), row(0, h - 1), row(w - 1, h - 1)});
+    const int hi = std::max({row(0, 0), row(w - 1, 0), row(0, h - 1), row(w - 1, h - 1)});
+
+    Pool::shared().run(hi - lo + 1, [&](std::size_t r) { render_line(src, dst, lo + static_cast<int>(r)); });
+}
+
+// Every pixel whose sheared row lies in [r, r + 1), interpolated between the running sums of rows r and r + 1.
+void
+LineBlur::render_line(const Image &src, const Image &dst, int r) const {
+    const int w = transpose ? src.h : src.w, h = transpose ? src.w : src.h;
+
+    auto row = [&](int k) {
+        return Sums(w, false, [&](int a) {
+            const auto m = static_cast<float>(a), v = static_cast<float>(r + k + a * slope);
+            return transpose ? sample(src, v, m) : sample(src, m, v);
+        });
+    };
+    const Sums row0 = row(0), row1 = row(1);
+
+    // The n taps sample [0, n - 1] steps away; as a box, each covers half a step to either side.
+    const double u0 = std::min(-0.5 * step, (n - 0.5) * step), u1 = std::max(-0.5 * step, (n - 0.5) * step);
+    for (int a = 0; a < w; ++a) {
+        const int b0 = static_cast<int>(std::ceil(r + a * slope));
+        for (int b = b0 - 1; b <= b0 + 1; ++b) {
+            if (b < 0 || b >= h || static_cast<int>(std::floor(b - a * slope)) != r)
+                continue;
+
+            const int x = transpose ? b : a, y = transpose ? a : b;
+            const Color base = load(src, x, y);
+            Color col = base;
+            if (n > 1 && u1 - u0 > 1.0e-6) {
+                const auto f = static_cast<float>(b - a * slope - r);
+                col = blend(row0.mean(a + u0, a + u1), row1.mean(a + u0, a + u1), f, n);
+            }
+
+            finish(dst, x, y, col, base, n, mix);
+        }
+    }
+}
+
+// Nearest and farthest distance from c to the image grown by the texel that bilinear filtering reaches past its edges.
+static std::array<double, 2>
+radii(const Image &img, const std::array<double, 2> &c) noexcept {
+    const double nx = std::max({-1.0 - c[0], 0.0, c[0] - img.w}), ny = std::max({-1.0 - c[1], 0.0, c[1] - img.h});
+    const double fx = std::max(std::abs(c[0] + 1.0), std::abs(img.w - c[0]));
+    const double fy = std::max(std::abs(c[1] + 1.0), std::abs(img.h - c[1]));
+    return {std::hypot(nx, ny), std::hypot(fx, fy)};
+}
+
+// Angles [from, from + span] under which that grown image is seen from c; the whole turn when c lies inside. Nothing
+// outside them can be sampled, so a pivot far from the object does not pay for the rest of the circle.
+static std::array<double, 2>
+view_angles(const Image &img, const std::array<double, 2> &c) noexcept {
+    constexpr double tau = 2.0 * std::numbers::pi;
+    if (c[0] >= -1.0 && c[0] <= img.w && c[1] >= -1.0 && c[1] <= img.h)
+        return {0.0, tau};
+
+    const double ref = std::atan2((img.h - 1) * 0.5 - c[1], (img.w - 1) * 0.5 - c[0]);
+    double lo = 0.0, hi = 0.0;
+    for (const double x : {-1.0, static_cast<double>(img.w)})
+        for (const double y : {-1.0, static_cast<double>(img.h)}) {
+            const double t = std::remainder(std::atan2(y - c[1], x - c[0]) - ref, tau);
+            lo = std::min(lo, t);
+            hi = std::max(hi, t);
+        }
+    return {ref + lo, hi - lo};
+}
+
+RotationBlur::RotationBlur(const Delta::Motion &motion, const Vec2<double> &pivot, int n_, double mix_) :
+    angle(std::atan2(motion.xform(1, 0), motion.xform(0, 0))), center{pivot.x() - 0.5, pivot.y() - 0.5},
+    n(std::max(n_, 1)), mix(static_cast<float>(mix_)) {}
+
+void
+RotationBlur::render(const Image &src, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    const auto [near, far] = radii(src, center);
+    const auto [from, span] = view_angles(src, center);
+
+    const int first = static_cast<int>(near);
+    Pool::shared().run(static_cast<int>(far) - first + 1,
+                       [&](std::size_t r) { render_ring(src, dst, first + static_cast<int>(r), from, span); });
+}
+
+// Every pixel at a radius in [r, r + 1), interpolated between the running sums of circles r and r + 1.
+void
+RotationBlur::render_ring(const Image &src, const Image &dst, int r, double from, double span) const {
+    constexpr double tau = 2.0 * std::numbers::pi;
+
+    // The n taps sample [0, n - 1] angles away; as a box, each covers half an angle to either side. A box that can
+    // reach around to the other side of the arc needs the whole circle.
+    const double t0 = std::min(-0.5 * angle, (n - 0.5) * angle), t1 = std::max(-0.5 * angle, (n - 0.5) * angle);
+    const bool closed = span + (t1 - t0) >= tau;
+    if (closed)
+        span = tau;
+
+    // About one texel of arc per sample, from the angle from.
+    auto circle = [&](int k) {
+        const double rho = r + k;
+        const int size = closed ? std::max(static_cast<int>(std::ceil(tau * rho)), 8)
+                                : static_cast<int>(std::ceil(span * std::max(rho, 1.0))) + 1;
+        const double unit = closed ? size / tau : std::max(rho, 1.0);
+
+        const double c = std::cos(1.0 / unit), s = std::sin(1.0 / unit);
+        double px = rho * std::cos(from), py = rho * std::sin(from);
+        return std::pair(Sums(size, closed, [&](int) {
+                             const Color col = sample(src, static_cast<float>(center[0] + px),
+                                                      static_cast<float>(center[1] + py));
+                             const double qx = c * px - s * py;
+                             py = s * px + c * py;
+                             px = qx;
+                             return col;
+                         }),
+                         unit);
+    };
+    const auto [circle0, unit0] = circle(0);
+    const auto [circle1, unit1] = circle(1);
+
+    // Scanlines through the ring, each crossing it at most twice; the pixels are checked against the same radius.
+    const int y0 = std::max(static_cast<int>(std::floor(center[1] - r - 2)), 0);
+    const int y1 = std::min(static_cast<int>(std::ceil(center[1] + r + 2)), src.h - 1);
+    for (int y = y0; y <= y1; ++y) {
+        const double dy = y - center[1];
+        const double outer = std::sqrt(std::max((r + 1.0) * (r + 1.0) - dy * dy, 0.0)) + 1.0;
+        const double inner = std::sqrt(std::max(r * r - dy * dy, 0.0)) - 1.0;
+
+        auto span_x = [&](double a, double b) {
+            const int x0 = std::max(static_cast<int>(std::floor(center[0] + a)), 0);
+            const int x1 = std::min(static_cast<int>(std::ceil(center[0] + b)), src.w - 1);
+            for (int x = x0; x <= x1; ++x) {
+                const double dx = x - center[0];
+                const double rho = std::hypot(dx, dy);
+                if (static_cast<int>(rho) != r)
+                    continue;
+
+                const Color base = load(src, x, y);
+                Color col = base;
+                if (n > 1 && t1 - t0 > 1.0e-9) {
+                    const double t = std::remainder(std::atan2(dy, dx) - from - span * 0.5, tau) + span * 0.5;
+                    col = blend(circle0.mean((t + t0) * unit0, (t + t1) * unit0),
+                                circle1.mean((t + t0) * unit1, (t + t1) * unit1), static_cast<float>(rho - r), n);
+                }
+
+                finish(dst, x, y, col, base, n, mix);
+            }
+        };
+
+        if (inner <= 0.0) {
+            span_x(-outer, outer);
+        } else {
+            span_x(-outer, -inner);
+            span_x(inner, outer);
+        }
+    }
+}
+
+ZoomBlur::ZoomBlur(const Delta::Motion &motion, const Vec2<double> &pivot, int n_, double mix_) :
+    step(std::log(motion.scale[0])), center{pivot.x() - 0.5, pivot.y() - 0.5}, n(std::max(n_, 1)),
+    mix(static_cast<float>(mix_)) {}
+
+void
+ZoomBlur::render(const Image &src, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    // About one texel of arc between rays at the farthest point of the image, in blocks that share their end rays.
+    constexpr double tau = 2.0 * std::numbers::pi;
+    constexpr int block = 16;
+    const auto [near, far] = radii(src, center);
+    const auto [from, span] = view_angles(src, center);
+    const int first = static_cast<int>(near), length = static_cast<int>(std::ceil(far)) + 1 - first;
+
+    Fan fan;
+    int wedges;
+    if (span >= tau) {
+        wedges = std::max(static_cast<int>(std::ceil(tau * far)), 8);
+        fan = {from, tau / wedges, wedges, first, length};
+    } else {
+        wedges = std::max(static_cast<int>(std::ceil(span * far)), 1);
+        fan = {from, span / wedges, 0, first, length};
+    }
+
+    Pool::shared().run((wedges + block - 1) / block, [&](std::size_t b) {
+        const int k0 = static_cast<int>(b) * block;
+        render_wedges(src, dst, fan, k0, std::min(k0 + block, wedges));
+    });
+}
+
+// Every pixel between rays k and k + 1, interpolated between their running sums. Pixels are assigned by which side of
+// each ray they lie on, computed the same way for both wedges that share it.
+void
+ZoomBlur::render_wedges(const Image &src, const Image &dst, const Fan &fan, int k0, int k1) const {
+    auto dir = [&](double k) {
+        const double t = fan.from + fan.step * (fan.period && k >= fan.period ? k - fan.period : k);
+        return std::array{std::cos(t), std::sin(t)};
+    };
+    std::vector<std::array<double, 2>> dirs;
+    std::vector<LogSums> sums;
+    dirs.reserve(k1 - k0 + 1);
+    sums.reserve(k1 - k0 + 1);
+    for (int k = k0; k <= k1; ++k) {
+        const auto d = dirs.emplace_back(dir(k));
+        sums.emplace_back(fan.first, fan.length, [&](int m) {
+            return sample(src, static_cast<float>(center[0] + (m + 0.5) * d[0]),
+                          static_cast<float>(center[1] + (m + 0.5) * d[1]));
+        });
+    }
+
+    // The n taps sample [0, n - 1] factors away; as a box, each covers half a factor to either side in log radius.
+    const double e0 = std::exp(std::min(-0.5 * step, (n - 0.5) * step));
+    const double e1 = std::exp(std::max(-0.5 * step, (n - 0.5) * step));
+
+    for (int k = k0; k < k1; ++k) {
+        const auto &d0 = dirs[k - k0], &d1 = dirs[k - k0 + 1];
+        const auto mid = dir(k + 0.5);
+
+        auto render_px = [&](int x, int y) {
+            const double dx = x - center[0], dy = y - center[1];
+            const double c0 = d0[0] * dy - d0[1] * dx, c1 = d1[0] * dy - d1[1] * dx;
+            const bool origin = dx == 0.0 && dy == 0.0;
+            if (origin ? k != 0 : !(c0 >= 0.0 && c1 < 0.0 && mid[0] * dx + mid[1] * dy > 0.0))
+                return;
+
+            const Color base = load(src, x, y);
+            Color col = base;
+            if (const double rho = std::hypot(dx, dy); n > 1 && e1 - e0 > 1.0e-9 && !origin) {
+                const auto f = static_cast<float>(c0 / (c0 - c1));
+                col = blend(sums[k - k0].mean(rho * e0, rho * e1), sums[k - k0 + 1].mean(rho * e0, rho * e1), f, n);
+            }
+
+            finish(dst, x, y, col, base, n, mix);
+        };
+
+        // March outwards along the axis closer to the wedge, across the few texels between its rays.
+        const bool transpose = std::abs(mid[1]) > std::abs(mid[0]);
+        const int j = transpose ? 1 : 0, size = transpose ? src.h : src.w, other = transpose ? src.w : src.h;
+        const int sign = mid[j] > 0.0 ? 1 : -1;
+        const double t0 = d0[1 - j] / d0[j], t1 = d1[1 - j] / d1[j];
+
+        int a = std::clamp(static_cast<int>(sign > 0 ? std::floor(center[j]) - 1 : std::ceil(center[j]) + 1), 0,
+                           size - 1);
+        for (; a >= 0 && a < size; a += sign) {
+            const double da = a - center[j];
+            const double b0 = center[1 - j] + da * t0, b1 = center[1 - j] + da * t1;
+            const int lo = std::max(static_cast<int>(std::floor(std::min(b0, b1))) - 1, 0);
+            const int hi = std::min(static_cast<int>(std::ceil(std::max(b0, b1))) + 1, other - 1);
+            for (int b = lo; b <= hi; ++b) transpose ? render_px(b, a) : render_px(a, b);
+        }
+    }
+}
+
+TiledBlur::TiledBlur(const Delta &delta, double amt, const Tiles &tiles_, const Vec2<double> &pivot, double mix) :
+    tiles(tiles_), levels(), tasks(), costs() {
+    const int size = std::max(tiles.size, 1);
+    const int most = tiles.smp.empty() ? 0 : std::ranges::max(tiles.smp);
+
+    // Level k blurs with 2^k samples, the last with most + 1.
+    const int top = std::bit_width(static_cast<unsigned>(most));
+    levels.reserve(top + 1);
+    for (int k = 0; k <= top; ++k) {
+        const int smp = std::min((1 << k) - 1, most);
+        levels.emplace_back(build_taps(delta, amt, smp), pivot, mix);
+    }
+
+    tasks.reserve(tiles.smp.size());
+    costs.reserve(tiles.smp.size());
+    for (std::size_t i = 0; i < tiles.smp.size(); ++i) {
+        const int level = std::bit_width(static_cast<unsigned>(tiles.smp[i]));
+        tasks.push_back({static_cast<int>(i), level});
+        costs.push_back((std::size_t{1} << level) * size * size);
+    }
+}
+
+void
+TiledBlur::render(const Image &src, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    const int size = std::max(tiles.size, 1);
+    Pool::shared().run(costs, [&](std::size_t i) {
+        const Task &task = tasks[i];
+        const int x0 = task.tile % tiles.cols * size, y0 = task.tile / tiles.cols * size;
+        levels[task.level].render_rect(src, dst, x0, y0, std::min(x0 + size, src.w), std::min(y0 + size, src.h));
+    });
+}
+
+void
+TableBlur::render_px(const Image &src, const Image &level, const Image &dst, int x, int y) const noexcept {
+    const float px = static_cast<float>(x);
+    const float py = static_cast<float>(y);
+
+    const Color base = load(src, x, y);
+    Color col = base;
+    for (const auto &m : maps) {
+        const Color c = sample(level, m[0] * px + m[2] * py + m[4], m[1] * px + m[3] * py + m[5]);
+        for (std::size_t i = 0; i < col.size(); ++i) col[i] += c[i];
+    }
+
+    finish(dst, x, y, col, base, n, mix);
+}
+
+MipBlur::MipBlur(const std::vector<double> &taps, const Vec2<double> &pivot, int lod_, double mix_,
+                 Precision precision) :
+    lod(std::max(lod_, 0)), table(taps, pivot, mix_, lod, precision) {}
+
+void
+MipBlur::render(const Image &src, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    // Each level is the 2x2 mean of the one below, transparent past its edges like the texels it stands for.
+    std::vector<std::vector<float>> pixels(lod);
+    Image level = src;
+    for (auto &px : pixels) {
+        const Image prev = level;
+        const int w = (prev.w + 1) / 2, h = (prev.h + 1) / 2;
+        px.resize(static_cast<std::size_t>(w) * h * 4);
+        level = {px.data(), w, h, static_cast<std::ptrdiff_t>(w) * 16, Depth::f32};
+
+        Pool::shared().run(h, [&](std::size_t row) {
+            const int y = static_cast<int>(row);
+            auto fetch = [&](int i, int j) { return i < prev.w && j < prev.h ? load(prev, i, j) : Color{}; };
+            for (int x = 0; x < w; ++x) {
+                const Color c00 = fetch(x * 2, y * 2), c10 = fetch(x * 2 + 1, y * 2);
+                const Color c01 = fetch(x * 2, y * 2 + 1), c11 = fetch(x * 2 + 1, y * 2 + 1);
+                Color c;
+                for (std::size_t i = 0; i < c.size(); ++i) c[i] = (c00[i] + c10[i] + c01[i] + c11[i]) * 0.25f;
+                store(level, x, y, c);
+            }
+        });
+    }
+
+    table.render(src, level, dst);
+}
+
+Doubling::Doubling(const std::vector<Mat3<double>> &passes, const Vec2<double> &pivot_, double mix_) :
+    maps(), pivot{static_cast<float>(pivot_.x()), static_cast<float>(pivot_.y())}, mix(static_cast<float>(mix_)) {
+    // Without passes the identity map leaves the source, as the single pass does with one sample.
+    auto to_map = [](const Mat3<double> &m) {
+        Map map;
+        for (std::size_t i = 0; i < map.size(); ++i) map[i] = static_cast<float>(m(i % 2, i / 2));
+        return map;
+    };
+
+    maps.reserve(std::max<std::size_t>(passes.size(), 1));
+    for (const auto &m : passes) maps.push_back(to_map(m));
+    if (maps.empty())
+        maps.push_back(to_map(Mat3<double>::identity()));
+}
+
+void
+Doubling::render(const Image &src, const Image &dst) const {
+    if (!src.is_same_shape(dst) || src.data == dst.data)
+        throw std::invalid_argument("Incompatible images.");
+
+    const std::size_t px = static_cast<std::size_t>(src.w) * static_cast<std::size_t>(src.h);
+    std::array<std::vector<Color>, 2> buf;
+    for (auto &b : buf) b.resize(maps.size() > 1 ? px : 0);
+
+    auto to_image = [&](std::vector<Color> &b) {
+        return Image{b.data(), src.w, src.h, static_cast<std::ptrdiff_t>(src.w) * 16, Depth::f32};
+    };
+
+    Image in = src;
+    for (std::size_t k = 0; k < maps.size(); ++k) {
+        const bool last = k + 1 == maps.size();
+        const Image out = last ? dst : to_image(buf[k % 2]);
+        Pool::shared().run(src.h,
+                           [&](std::size_t y) { render_row(in, out, src, maps[k], last, static_cast<int>(y)); });
+        in = out;
+    }
+}
+
+void
+Doubling::render_row(const Image &in, const Image &out, const Image &base, const Map &map, bool last, int y) const
+        noexcept {
+    const float unit = base.depth == Depth::u8 ? 1.0f / 255.0f : 1.0f;
+    const float py = (static_cast<float>(y) + 0.5f) - pivot[1];
+
+    for (int x = 0; x < in.w; ++x) {
+        const float px = (static_cast<float>(x) + 0.5f) - pivot[0];
+        const float qx = map[0] * px + map[2] * py + map[4];
+        const float qy = map[1] * px + map[3] * py + map[5];
+
+        Color col = load(in, x, y);
+        const Color c = sample(in, qx + pivot[0] - 0.5f, qy + pivot[1] - 0.5f);
+        for (std::size_t i = 0; i < col.size(); ++i) col[i] = (col[i] + c[i]) * 0.5f;
+
+        if (last) {
+            const Color b = load(base, x, y);
+            const float a = 1.0f - col[3] * unit;
+            for (std::size_t i = 0; i < col.size(); ++i) col[i] += b[i] * a * mix;
+        }
+
+        store(out, x, y, col);
+    }
+}
+
+#if defined(__AVX2__)
+struct Color8 {
+    __m256 c[4];
+};
+
+static Color8
+gather8(const Image &img, __m256i x, __m256i y, __m256i mask) noexcept {
+    const auto *base = static_cast<const std::byte *>(img.data);
+    const __m256i ofs = _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(static_cast<int>(img.pitch))),
+                                         _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(img.bpp()))));
+
+    Color8 col;
+    if (img.depth == Depth::u8) {
+        const __m256i px = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int *>(base),
+                                                       ofs, mask, 1);
+        const __m256i lo = _mm256_set1_epi32(0xff);
+        for (int i = 0; i < 4; ++i)
+            col.c[i] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, i * 8), lo));
+    } else {
+        const __m256 m = _mm256_castsi256_ps(mask);
+        for (int i = 0; i < 4; ++i) {
+            const __m256i o = _mm256_add_epi32(ofs, _mm256_set1_epi32(i * 4));
+            col.c[i] = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), reinterpret_cast<const float *>(base), o, m, 1);
+        }
+    }
+    return col;
+}
+
+static __m256i
+in_range(__m256i v, int size) noexcept {
+    return _mm256_and_si256(_mm256_cmpgt_epi32(v, _mm256_set1_epi32(-1)),
+                            _mm256_cmpgt_epi32(_mm256_set1_epi32(size), v));
+}
+
+// Adds the bilinear sample at texel coordinates (u, v) of each lane, with a transparent border.
+static void
+accumulate8(const Image &src, __m256 u, __m256 v, Color8 &col) noexcept {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 fone = _mm256_set1_ps(1.0f);
+
+    const __m256 fx = _mm256_floor_ps(u);
+    const __m256 fy = _mm256_floor_ps(v);
+    const __m256 wx = _mm256_sub_ps(u, fx);
+    const __m256 wy = _mm256_sub_ps(v, fy);
+    const __m256i x0 = _mm256_cvttps_epi32(fx);
+    const __m256i y0 = _mm256_cvttps_epi32(fy);
+    const __m256i x1 = _mm256_add_epi32(x0, one);
+    const __m256i y1 = _mm256_add_epi32(y0, one);
+
+    const __m256i mx0 = in_range(x0, src.w), mx1 = in_range(x1, src.w);
+    const __m256i my0 = in_range(y0, src.h), my1 = in_range(y1, src.h);
+
+    const Color8 c00 = gather8(src, x0, y0, _mm256_and_si256(mx0, my0));
+    const Color8 c10 = gather8(src, x1, y0, _mm256_and_si256(mx1, my0));
+    const Color8 c01 = gather8(src, x0, y1, _mm256_and_si256(mx0, my1));
+    const Color8 c11 = gather8(src, x1, y1, _mm256_and_si256(mx1, my1));
+
+    const __m256 ix = _mm256_sub_ps(fone, wx);
+    const __m256 iy = _mm256_sub_ps(fone, wy);
+    const __m256 w00 = _mm256_mul_ps(ix, iy);
+    const __m256 w10 = _mm256_mul_ps(wx, iy);
+    const __m256 w01 = _mm256_mul_ps(ix, wy);
+    const __m256 w11 = _mm256_mul_ps(wx, wy);
+
+    for (int i = 0; i < 4; ++i) {
+        __m256 s = _mm256_mul_ps(c00.c[i], w00);
+        s = _mm256_add_ps(s, _mm256_mul_ps(c10.c[i], w10));
+        s = _mm256_add_ps(s, _mm256_mul_ps(c01.c[i], w01));
+        s = _mm256_add_ps(s, _mm256_mul_ps(c11.c[i], w11));
+        col.c[i] = _mm256_add_ps(col.c[i], s);
+    }
+}
+
+// Eight-lane finish().
+static void
+finish8(const Image &dst, int x, int y, Color8 col, const Color8 &base, int n, float mix) noexcept {
+    const float unit = dst.depth == Depth::u8 ? 1.0f / 255.0f : 1.0f;
+    const __m256 rn = _mm256_set1_ps(1.0f / static_cast<float>(n));
+    for (auto &c : col.c) c = _mm256_mul_ps(c, rn);
+
+    const __m256 a = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(col.c[3], _mm256_set1_ps(unit)));
+    for (int i = 0; i < 4; ++i)
+        col.c[i] = _mm256_add_ps(col.c[i], _mm256_mul_ps(_mm256_mul_ps(base.c[i], a), _mm256_set1_ps(mix)));
+
+    auto *ptr = static_cast<std::byte *>(dst.data) + y * dst.pitch + x * dst.bpp();
+    if (dst.depth == Depth::u8) {
+        const __m256i lo = _mm256_setzero_si256();
+        const __m256i hi = _mm256_set1_epi32(255);
+        __m256i px8 = _mm256_setzero_si256();
+        for (int i = 0; i < 4; ++i) {
+            const __m256i c = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvtps_epi32(col.c[i]), lo), hi);
+            px8 = _mm256_or_si256(px8, _mm256_slli_epi32(c, i * 8));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(ptr), px8);
+    } else {
+        alignas(32) std::array<std::array<float, 8>, 4> soa;
+        for (int i = 0; i < 4; ++i) _mm256_store_ps(soa[i].data(), col.c[i]);
+
+        auto *out = reinterpret_cast<float *>(ptr);
+        for (int j = 0; j < 8; ++j)
+            for (int i = 0; i < 4; ++i) out[j * 4 + i] = soa[i][j];
+    }
+}
+
+void
+Blur::render_x8(const Image &src, const Image &dst, int x, int y) const noexcept {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i xi = _mm256_add_epi32(_mm256_set1_epi32(x), lane);
+    const __m256i yi = _mm256_set1_epi32(y);
+
+    const __m256 p00 = _mm256_set1_ps(pose[0]), p10 = _mm256_set1_ps(pose[1]);
+    const __m256 p01 = _mm256_set1_ps(pose[2]), p11 = _mm256_set1_ps(pose[3]);
+
+    __m256 px = _mm256_sub_ps(_mm256_add_ps(_mm256_cvtepi32_ps(xi), _mm256_set1_ps(0.5f)), _mm256_set1_ps(pivot[0]));
+    __m256 py = _mm256_set1_ps((static_cast<float>(y) + 0.5f) - pivot[1]);
+
+    const Color8 base = gather8(src, xi, yi, _mm256_set1_epi32(-1));
+    Color8 col = base;
+
+    for (const auto &tap : taps) {
+        const __m256 qx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p00, px), _mm256_mul_ps(p01, py)),
+                                        _mm256_set1_ps(tap.tx));
+        const __m256 qy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p10, px), _mm256_mul_ps(p11, py)),
+                                        _mm256_set1_ps(tap.ty));
+        px = qx;
+        py = qy;
+
+        const __m256 u = _mm256_sub_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(tap.sx), px), _mm256_set1_ps(tap.dx)),
+                              _mm256_set1_ps(pivot[0])),
+                _mm256_set1_ps(0.5f));
+        const __m256 v = _mm256_sub_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(tap.sy), py), _mm256_set1_ps(tap.dy)),
+                              _mm256_set1_ps(pivot[1])),
+                _mm256_set1_ps(0.5f));
+        accumulate8(src, u, v, col);
+    }
+
+    finish8(dst, x, y, col, base, n, mix);
+}
+
+// Texel coordinates of the eight lanes under one column-major 2x3 map.
+static void
+apply8(const std::array<float, 6> &m, __m256 px, __m256 py, __m256 &u, __m256 &v) noexcept {
+    u = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[0]), px), _mm256_mul_ps(_mm256_set1_ps(m[2]), py)),
+            _mm256_set1_ps(m[4]));
+    v = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[1]), px), _mm256_mul_ps(_mm256_set1_ps(m[3]), py)),
+            _mm256_set1_ps(m[5]));
+}
+
+// Eight pixels as four vectors of whole pixels, two each, instead of one vector per channel.
+struct Pixels8 {
+    __m256 p[4];
+};
+
+struct Fixed8 {
+    __m256i p[4];
+};
+
+// One vector per channel, where vector k holds pixel k in its low half and pixel k + 4 in its high half.
+static Color8
+planar(const Pixels8 &px) noexcept {
+    const __m256 t0 = _mm256_unpacklo_ps(px.p[0], px.p[1]), t1 = _mm256_unpacklo_ps(px.p[2], px.p[3]);
+    const __m256 t2 = _mm256_unpackhi_ps(px.p[0], px.p[1]), t3 = _mm256_unpackhi_ps(px.p[2], px.p[3]);
+    return {{_mm256_shuffle_ps(t0, t1, 0x44), _mm256_shuffle_ps(t0, t1, 0xee), _mm256_shuffle_ps(t2, t3, 0x44),
+             _mm256_shuffle_ps(t2, t3, 0xee)}};
+}
+
+// Fixed-point accumulate8() for 8-bit sources, with 8-bit weights. Each channel sits next to the one of its right
+// (then lower) neighbour in 16-bit lanes, so one multiply-add applies a pair of weights. The sums are in 1/128 of a
+// level, 32640 per tap at most, which keeps 4096 taps well inside 32 bits. Vector k holds pixels k and k + 4.
+static void
+accumulate8_fixed(const Image &src, __m256 u, __m256 v, Fixed8 &acc) noexcept {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i unit = _mm256_set1_epi32(256);
+    const __m256i zero = _mm256_setzero_si256();
+
+    const __m256 fx = _mm256_floor_ps(u);
+    const __m256 fy = _mm256_floor_ps(v);
+    const __m256i wx = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_sub_ps(u, fx), _mm256_set1_ps(256.0f)));
+    const __m256i wy = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_sub_ps(v, fy), _mm256_set1_ps(256.0f)));
+    const __m256i x0 = _mm256_cvttps_epi32(fx);
+    const __m256i y0 = _mm256_cvttps_epi32(fy);
+    const __m256i x1 = _mm256_add_epi32(x0, one);
+    const __m256i y1 = _mm256_add_epi32(y0, one);
+
+    const __m256i mx0 = in_range(x0, src.w), mx1 = in_range(x1, src.w);
+    const __m256i my0 = in_range(y0, src.h), my1 = in_range(y1, src.h);
+
+    // Weight pairs (1 - w, w) of each pixel, spread over the four channels of vector k.
+    const __m256i px = _mm256_or_si256(_mm256_sub_epi32(unit, wx), _mm256_slli_epi32(wx, 16));
+    const __m256i py = _mm256_or_si256(_mm256_sub_epi32(unit, wy), _mm256_slli_epi32(wy, 16));
+    const Fixed8 kx = {{_mm256_shuffle_epi32(px, 0x00), _mm256_shuffle_epi32(px, 0x55),
+                        _mm256_shuffle_epi32(px, 0xaa), _mm256_shuffle_epi32(px, 0xff)}};
+    const Fixed8 ky = {{_mm256_shuffle_epi32(py, 0x00), _mm256_shuffle_epi32(py, 0x55),
+                        _mm256_shuffle_epi32(py, 0xaa), _mm256_shuffle_epi32(py, 0xff)}};
+
+    const __m256i pitch = _mm256_set1_epi32(static_cast<int>(src.pitch));
+    auto fetch = [&](__m256i x, __m256i y, __m256i mask) {
+        const __m256i ofs = _mm256_add_epi32(_mm256_mullo_epi32(y, pitch), _mm256_slli_epi32(x, 2));
+        return _mm256_mask_i32gather_epi32(zero, static_cast<const int *>(src.data), ofs, mask, 1);
+    };
+
+    // Rows of the footprint in 1/256 of a level, 65280 at most.
+    auto row = [&](__m256i y, __m256i my) {
+        const __m256i l = fetch(x0, y, _mm256_and_si256(mx0, my)), r = fetch(x1, y, _mm256_and_si256(mx1, my));
+        const __m256i lo = _mm256_unpacklo_epi8(l, r), hi = _mm256_unpackhi_epi8(l, r);
+        return Fixed8{{_mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), kx.p[0]),
+                       _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), kx.p[1]),
+                       _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), kx.p[2]),
+                       _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), kx.p[3])}};
+    };
+
+    const Fixed8 top = row(y0, my0), bottom = row(y1, my1);
+    for (int k = 0; k < 4; ++k) {
+        // Halved to fit signed 16 bits for the vertical pass.
+        const __m256i rows = _mm256_or_si256(_mm256_srli_epi32(top.p[k], 1),
+                                             _mm256_slli_epi32(_mm256_srli_epi32(bottom.p[k], 1), 16));
+        acc.p[k] = _mm256_add_epi32(acc.p[k], _mm256_srli_epi32(_mm256_madd_epi16(rows, ky.p[k]), 8));
+    }
+}
+
+// Half-float accumulate8(). A texel is a single 64-bit gather, and the filter runs on whole pixels, two per vector:
+// vector k holds pixels 2k and 2k + 1.
+static void
+accumulate8_half(const std::uint16_t *half, int w, int h, __m256 u, __m256 v, Pixels8 &acc) noexcept {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 fone = _mm256_set1_ps(1.0f);
+
+    const __m256 fx = _mm256_floor_ps(u);
+    const __m256 fy = _mm256_floor_ps(v);
+    const __m256 wx = _mm256_sub_ps(u, fx);
+    const __m256 wy = _mm256_sub_ps(v, fy);
+    const __m256i x0 = _mm256_cvttps_epi32(fx);
+    const __m256i y0 = _mm256_cvttps_epi32(fy);
+    const __m256i x1 = _mm256_add_epi32(x0, one);
+    const __m256i y1 = _mm256_add_epi32(y0, one);
+
+    const __m256i mx0 = in_range(x0, w), mx1 = in_range(x1, w);
+    const __m256i my0 = in_range(y0, h), my1 = in_range(y1, h);
+
+    auto fetch = [&](__m256i x, __m256i y, __m256i mask) {
+        const auto *base = reinterpret_cast<const long long *>(half);
+        const __m256i ofs = _mm256_slli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(w)), x), 3);
+        const __m256i lo = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), base, _mm256_castsi256_si128(ofs),
+                                                       _mm256_cvtepi32_epi64(_mm256_castsi256_si128(mask)), 1);
+        const __m256i hi = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), base,
+                                                       _mm256_extracti128_si256(ofs, 1),
+                                                       _mm256_cvtepi32_epi64(_mm256_extracti128_si256(mask, 1)), 1);
+        return Pixels8{
+                {_mm256_cvtph_ps(_mm256_castsi256_si128(lo)), _mm256_cvtph_ps(_mm256_extracti128_si256(lo, 1)),
+                 _mm256_cvtph_ps(_mm256_castsi256_si128(hi)), _mm256_cvtph_ps(_mm256_extracti128_si256(hi, 1))}};
+    };
+
+    const auto c00 = fetch(x0, y0, _mm256_and_si256(mx0, my0));
+    const auto c10 = fetch(x1, y0, _mm256_and_si256(mx1, my0));
+    const auto c01 = fetch(x0, y1, _mm256_and_si256(mx0, my1));
+    const auto c11 = fetch(x1, y1, _mm256_and_si256(mx1, my1));
+
+    const __m256 ix = _mm256_sub_ps(fone, wx);
+    const __m256 iy = _mm256_sub_ps(fone, wy);
+    const __m256 w00 = _mm256_mul_ps(ix, iy);
+    const __m256 w10 = _mm256_mul_ps(wx, iy);
+    const __m256 w01 = _mm256_mul_ps(ix, wy);
+    const __m256 w11 = _mm256_mul_ps(wx, wy);
+
+    for (int k = 0; k < 4; ++k) {
+        const __m256i pick = _mm256_add_epi32(_mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1), _mm256_set1_epi32(k * 2));
+        __m256 s = _mm256_mul_ps(c00.p[k], _mm256_permutevar8x32_ps(w00, pick));
+        s = _mm256_add_ps(s, _mm256_mul_ps(c10.p[k], _mm256_permutevar8x32_ps(w10, pick)));
+        s = _mm256_add_ps(s, _mm256_mul_ps(c01.p[k], _mm256_permutevar8x32_ps(w01, pick)));
+        s = _mm256_add_ps(s, _mm256_mul_ps(c11.p[k], _mm256_permutevar8x32_ps(w11, pick)));
+        acc.p[k] = _mm256_add_ps(acc.p[k], s);
+    }
+}
+
+void
+TableBlur::render_x8(const Image &src, const Image &level, const Image &dst, int x, int y) const noexcept {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i xi = _mm256_add_epi32(_mm256_set1_epi32(x), lane);
+    const __m256i yi = _mm256_set1_epi32(y);
+
+    // The pivot and texel center offsets are folded into the table; (x, y) maps straight to texel coordinates.
+    const __m256 px = _mm256_cvtepi32_ps(xi);
+    const __m256 py = _mm256_set1_ps(static_cast<float>(y));
+
+    const Color8 base = gather8(src, xi, yi, _mm256_set1_epi32(-1));
+    Color8 col = base;
+
+    for (const auto &m : maps) {
+        __m256 u, v;
+        apply8(m, px, py, u, v);
+        accumulate8(level, u, v, col);
+    }
+
+    finish8(dst, x, y, col, base, n, mix);
+}
+
+void
+TableBlur::render_x8_fixed(const Image &src, const Image &level, const Image &dst, int x, int y) const noexcept {
+    const __m256i xi = _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256 px = _mm256_cvtepi32_ps(xi);
+    const __m256 py = _mm256_set1_ps(static_cast<float>(y));
+
+    Fixed8 acc{};
+    for (const auto &m : maps) {
+        __m256 u, v;
+        apply8(m, px, py, u, v);
+        accumulate8_fixed(level, u, v, acc);
+    }
+
+    Pixels8 sum;
+    for (int k = 0; k < 4; ++k) sum.p[k] = _mm256_mul_ps(_mm256_cvtepi32_ps(acc.p[k]), _mm256_set1_ps(1.0f / 128.0f));
+
+    const Color8 base = gather8(src, xi, _mm256_set1_epi32(y), _mm256_set1_epi32(-1));
+    Color8 col = planar(sum);
+    for (int i = 0; i < 4; ++i) col.c[i] = _mm256_add_ps(col.c[i], base.c[i]);
+
+    finish8(dst, x, y, col, base, n, mix);
+}
+
+void
+TableBlur::render_x8_half(const Image &src, const Image &level, const std::uint16_t *half, const Image &dst, int x,
+                          int y) const noexcept {
+    const __m256i xi = _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256 px = _mm256_cvtepi32_ps(xi);
+    const __m256 py = _mm256_set1_ps(static_cast<float>(y));
+
+    Pixels8 acc{};
+    for (const auto &m : maps) {
+        __m256 u, v;
+        apply8(m, px, py, u, v);
+        accumulate8_half(half, level.w, level.h, u, v, acc);
+    }
+
+    // planar() pairs pixels k and k + 4, which leaves the even pixels in the low half here.
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const Color8 base = gather8(src, xi, _mm256_set1_epi32(y), _mm256_set1_epi32(-1));
+    Color8 col = planar(acc);
+    for (int i = 0; i < 4; ++i) col.c[i] = _mm256_add_ps(_mm256_permutevar8x32_ps(col.c[i], order), base.c[i]);
+
+    finish8(dst, x, y, col, base, n, mix);
+}
+#endif
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "structs.hpp"
+#include "transform.hpp"
+#include "vector/vector.hpp"
+
+// Channel order does not matter as long as alpha is the last channel (BGRA or RGBA).
+enum class Depth {
+    u8,
+    f32
+};
+
+struct Image {
+    void *data;
+    int w, h;
+    std::ptrdiff_t pitch;
+    Depth depth;
+
+    [[nodiscard]] constexpr std::ptrdiff_t bpp() const noexcept { return depth == Depth::u8 ? 4 : 16; }
+    [[nodiscard]] constexpr bool is_same_shape(const Image &other) const noexcept {
+        return w == other.w && h == other.h && depth == other.depth;
+    }
+};
+
+// CPU counterpart of shaders/motion_blur.hlsl.
+class Blur {
+public:
+    Blur(const Delta::Motion &motion, const Vec2<double> &pivot_, int n_, double mix_);
+
+    void render(const Image &src, const Image &dst) const;
+
+private:
+    struct Tap {
+        float tx, ty;
+        float sx, sy;
+        float dx, dy;
+    };
+
+    std::array<float, 4> pose;
+    std::array<float, 2> pivot;
+    std::vector<Tap> taps;
+    int n;
+    float mix;
+
+    void render_row(const Image &src, const Image &dst, int y) const noexcept;
+    void render_px(const Image &src, const Image &dst, int x, int y) const noexcept;
+#if defined(__AVX2__)
+    void render_x8(const Image &src, const Image &dst, int x, int y) const noexcept;
+#endif
+};
+
+// Arithmetic of the taps of TableBlur. fixed8 takes 8-bit bilinear weights and sums in 32-bit integers, and applies
+// to 8-bit tap sources only; f16 samples a half-float copy of the source, which mostly pays off for float sources. The
+// unblurred sample and the final average stay in float, and so do the last pixels of a row that do not fill eight
+// lanes, and builds without AVX2.
+enum class Precision {
+    f32,
+    fixed8,
+    f16
+};
+
+// CPU counterpart of shaders/motion_blur_table.hlsl. Every tap is one independent affine map from build_taps.
+class TableBlur {
+public:
+    TableBlur(const std::vector<double> &taps, const Vec2<double> &pivot, double mix_, int lod = 0,
+              Precision precision_ = Precision::f32);
+
+    void render(const Image &src, const Image &dst) const;
+
+    // Taps are sampled from level, src reduced 2^lod times as in MipBlur; the base sample still comes from src.
+    void render(const Image &src, const Image &level, const Image &dst) const;
+
+    // Pixels [x0, x1) x [y0, y1) only, on the calling thread. The images are not checked, and Precision::f16 runs in
+    // f32 since the half-float copy belongs to render().
+    void render_rect(const Image &src, const Image &dst, int x0, int y0, int x1, int y1) const noexcept;
+
+private:
+    // Column-major 2x3, taking texel coordinates to texel coordinates.
+    using Map = std::array<float, 6>;
+
+    std::vector<Map> maps;
+    int n;
+    float mix;
+    Precision precision;
+
+    // half is the half-float copy of level for Precision::f16, four channels per texel and w * 8 bytes per row.
+    void render_row(const Image &src, const Image &level, const std::uint16_t *half, const Image &dst, int y, int x0,
+                    int x1) const noexcept;
+    void render_px(const Image &src, const Image &level, const Image &dst, int x, int y) const noexcept;
+#if defined(__AVX2__)
+    void render_x8(const Image &src, const Image &level, const Image &dst, int x, int y) const noexcept;
+    void render_x8_fixed(const Image &src, const Image &level, const Image &dst, int x, int y) const noexcept;
+    void render_x8_half(const Image &src, const Image &level, const std::uint16_t *half, const Image &dst, int x,
+                        int y) const noexcept;
+#endif
+};
+
+// Blur of Kernel::translate, where tap i is the pixel moved by i times one offset. The n taps become a box filter over
+// the segment they span, integrated with running sums along rows sheared to the motion, so the cost does not depend on
+// n. Approximates TableBlur within the rounding of the taps to the box.
+class LineBlur {
+public:
+    LineBlur(const Delta::Motion &motion, int n_, double mix_);
+
+    void render(const Image &src, const Image &dst) const;
+
+private:
+    // Offset per tap along the major axis of the motion and the minor axis change per major texel.
+    double step;
+    double slope;
+    bool transpose;
+    int n;
+    float mix;
+
+    void render_line(const Image &src, const Image &dst, int r) const;
+};
+
+// Blur of Kernel::rotate, where tap i is the pixel turned i times by one angle about the pivot. Rings of the image are
+// resampled in polar coordinates, and the taps become a box along the angle like in LineBlur, so the cost depends
+// neither on n nor on the angle.
+class RotationBlur {
+public:
+    RotationBlur(const Delta::Motion &motion, const Vec2<double> &pivot, int n_, double mix_);
+
+    void render(const Image &src, const Image &dst) const;
+
+private:
+    // Angle per tap and the pivot in texel coordinates.
+    double angle;
+    std::array<double, 2> center;
+    int n;
+    float mix;
+
+    // Pixels at radii [r, r + 1), from circles sampled over angles [from, from + span] or the whole turn.
+    void render_ring(const Image &src, const Image &dst, int r, double from, double span) const;
+};
+
+// Blur of Kernel::zoom, where tap i is the pixel scaled i times by one factor about the pivot. Rays from the pivot are
+// resampled, and the taps become a box along them in log radius, where they are evenly spaced, so the cost depends
+// neither on n nor on the factor.
+class ZoomBlur {
+public:
+    ZoomBlur(const Delta::Motion &motion, const Vec2<double> &pivot, int n_, double mix_);
+
+    void render(const Image &src, const Image &dst) const;
+
+private:
+    // Log of the factor per tap and the pivot in texel coordinates.
+    double step;
+    std::array<double, 2> center;
+    int n;
+    float mix;
+
+    // Rays from the pivot at angles from + k * step, repeating every period rays when they go all the way round and
+    // zero otherwise, each sampled over radii [first, first + length).
+    struct Fan {
+        double from, step;
+        int period;
+        int first, length;
+    };
+
+    // Pixels of wedges [k0, k1), wedge k lying between rays k and k + 1.
+    void render_wedges(const Image &src, const Image &dst, const Fan &fan, int k0, int k1) const;
+};
+
+// Variable-rate TableBlur over the tiles of build_tiles: each tile takes as many taps as it needs, rounded up to a
+// power of two so that few tap tables are built. Tiles run on the shared Pool, which deals them out heaviest first and
+// lets idle workers steal the cheap ones left over.
+class TiledBlur {
+public:
+    TiledBlur(const Delta &delta, double amt, const Tiles &tiles_, const Vec2<double> &pivot, double mix);
+
+    void render(const Image &src, const Image &dst) const;
+
+private:
+    struct Task {
+        int tile;
+        int level;
+    };
+
+    Tiles tiles;
+    std::vector<TableBlur> levels;
+    std::vector<Task> tasks;
+    std::vector<std::size_t> costs;
+};
+
+// TableBlur whose taps sample level lod of a pyramid of the image, each level the 2x2 mean of the one below. Taps up to
+// 2^lod texels apart still cover everything between them, so a long motion takes few taps without banding.
+class MipBlur {
+public:
+    MipBlur(const std::vector<double> &taps, const Vec2<double> &pivot, int lod_, double mix_,
+            Precision precision = Precision::f32);
+
+    void render(const Image &src, const Image &dst) const;
+
+private:
+    int lod;
+    TableBlur table;
+};
+
+// CPU counterpart of shaders/motion_blur_pass.hlsl, run once per map from build_passes. Intermediate passes are kept
+// in float.
+class Doubling {
+public:
+    Doubling(const std::vector<Mat3<double>> &passes, const Vec2<double> &pivot_, double mix_);
+
+    void render(const Image &src, const Image &dst) const;
+
+private:
+    using Map = std::array<float, 6>;
+
+    std::vector<Map> maps;
+    std::array<float, 2> pivot;
+    float mix;
+
+    void render_row(const Image &in, const Image &out, const Image &base, const Map &map, bool last, int y) const
+            noexcept;
+};
@@ -0,0 +1,194 @@
+#include "cache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <vector>
+
+// Directory name of a script: anything outside [0-9A-Za-z_-] becomes '_'.
+static std::string
+folder(const std::string &name) {
+    std::string s = name;
+    for (auto &c : s)
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-')
+            c = '_';
+
+    return s.empty() ? "_" : s;
+}
+
+// FNV-1a of a scene, stamped into its files; its hex digits name their directory.
+static std::uint64_t
+scene_key(const std::string &scene) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (const char c : scene) h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    return h;
+}
+
+GeoCache::Lease
+GeoCache::acquire(const std::string &name, const std::string &scene, int id) {
+    const std::size_t n = index(id);
+    auto &shard = table[n];
+    std::unique_lock lock(shard.mutex);
+
+    // Every shard holds an atlas of its own ids and clears its directory whole, so each gets one to itself.
+    auto [it, fresh] = shard.atlases[name].try_emplace(scene);
+    auto &atlas = it->second;
+    if (fresh && !root.empty() && !scene.empty()) {
+        const std::uint64_t key = scene_key(scene);
+        char hex[16];
+        const auto end = std::to_chars(hex, hex + sizeof(hex), key, 16).ptr;
+        atlas.persist(root / folder(name) / std::string(hex, end) / ("shard-" + std::to_string(n)), key);
+    }
+
+    atlas.set_time(clock.fetch_add(1, std::memory_order_relaxed) + 1);
+    return Lease(std::move(lock), this, &atlas, &shard.histories[name][scene]);
+}
+
+void
+GeoCache::clear(const std::string &name) {
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        if (auto it = shard.atlases.find(name); it != shard.atlases.end()) {
+            for (auto &[_, atlas] : it->second) {
+                const std::size_t base = atlas.bytes();
+                atlas.clear();
+                settle(atlas, base);
+            }
+        }
+
+        if (auto it = shard.histories.find(name); it != shard.histories.end())
+            for (auto &[_, history] : it->second) history.clear();
+    }
+
+    results.clear();
+}
+
+void
+GeoCache::clear() {
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        for (auto &[_, scenes] : shard.atlases) {
+            for (auto &[_, atlas] : scenes) {
+                const std::size_t base = atlas.bytes();
+                atlas.clear();
+                settle(atlas, base);
+            }
+        }
+
+        shard.histories.clear();
+    }
+
+    results.clear();
+}
+
+GeoCache::Usage
+GeoCache::usage() {
+    Usage usage{0, budget.load(), 0, 0, evicted_ids.load(), evicted_pages.load(), {}};
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        for (const auto &[_, scenes] : shard.atlases) {
+            for (const auto &[_, atlas] : scenes) {
+                usage.bytes += atlas.bytes();
+                usage.ids += atlas.ids();
+                usage.pages += atlas.page_count();
+
+                const auto &c = atlas.counters();
+                usage.traffic.hits += c.hits;
+                usage.traffic.file_hits += c.file_hits;
+                usage.traffic.misses += c.misses;
+                usage.traffic.writes += c.writes;
+                usage.traffic.overwrites += c.overwrites;
+            }
+        }
+    }
+    return usage;
+}
+
+std::vector<std::pair<std::string, std::size_t>>
+GeoCache::bytes_by_name() {
+    std::vector<std::pair<std::string, std::size_t>> list;
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        for (const auto &[name, scenes] : shard.atlases) {
+            std::size_t size = 0;
+            for (const auto &[_, atlas] : scenes) size += atlas.bytes();
+
+            auto it = std::ranges::find(list, name, &std::pair<std::string, std::size_t>::first);
+            if (it == list.end())
+                list.emplace_back(name, size);
+            else
+                it->second += size;
+        }
+    }
+    return list;
+}
+
+std::vector<std::pair<int, std::size_t>>
+GeoCache::bytes_by_id(const std::string &name) {
+    std::vector<std::pair<int, std::size_t>> list;
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        if (auto it = shard.atlases.find(name); it != shard.atlases.end())
+            for (const auto &[_, atlas] : it->second)
+                atlas.for_each_id([&](int id, std::size_t size) { list.emplace_back(id, size); });
+    }
+    std::ranges::sort(list);
+
+    // An id of several scenes counts once.
+    std::vector<std::pair<int, std::size_t>> merged;
+    for (const auto &[id, size] : list) {
+        if (!merged.empty() && merged.back().first == id)
+            merged.back().second += size;
+        else
+            merged.emplace_back(id, size);
+    }
+    return merged;
+}
+
+void
+GeoCache::trim() {
+    std::unique_lock guard(trimming, std::try_to_lock);
+    if (!guard || !is_over_budget())
+        return;
+
+    // Pages in use cannot go, so a trim may end above the budget; it is not retried until usage has grown by another
+    // eighth, or every call would sweep the whole cache for nothing. A clear in between resets that.
+    const std::size_t limit = budget.load(std::memory_order_relaxed);
+    const std::size_t used = bytes.load(std::memory_order_relaxed);
+    if (used >= settled && used - settled < limit / 8)
+        return;
+
+    // Nor do hash tables shrink as their ids go, so the target leaves them out: where ids were many, evicting every
+    // page would still not reach the budget.
+    std::size_t fixed = 0;
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        for (const auto &[_, scenes] : shard.atlases)
+            for (const auto &[_, atlas] : scenes) fixed += atlas.table_bytes();
+    }
+
+    // Clock over the shards: a visit drops what was not used since the last one, the first what was not used in the
+    // later half of the time so far, so pages go about oldest first without being listed. The hand goes at most one
+    // round and stays where it stopped.
+    const std::size_t low = limit - limit / 8 + fixed;
+    for (std::size_t visits = 0; visits < shards && bytes.load(std::memory_order_relaxed) > low; ++visits) {
+        auto &shard = table[hand];
+        hand = (hand + 1) % shards;
+
+        std::scoped_lock lock(shard.mutex);
+        const std::uint64_t now = clock.load(std::memory_order_relaxed);
+        const std::uint64_t cutoff = shard.swept ? shard.swept : now / 2;
+        shard.swept = now;
+
+        for (auto &[_, scenes] : shard.atlases) {
+            for (auto &[_, atlas] : scenes) {
+                const std::size_t base = atlas.bytes();
+                const auto [ids, pages] = atlas.evict(cutoff);
+                settle(atlas, base);
+                evicted_ids.fetch_add(ids, std::memory_order_relaxed);
+                evicted_pages.fetch_add(pages, std::memory_order_relaxed);
+            }
+        }
+    }
+    settled = bytes.load(std::memory_order_relaxed);
+}
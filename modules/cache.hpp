@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "geo.hpp"
+#include "governor.hpp"
+#include "history.hpp"
+#include "memo.hpp"
+#include "stats.hpp"
+
+using AtlasOct = Atlas<8>;
+
+// Geo caches of every script, sharded by object id. Calls for ids in different shards run concurrently; a Lease holds
+// its shard exclusively, since even Atlas::read moves the cursor.
+class GeoCache {
+public:
+    static constexpr std::size_t shards = 64;
+
+    struct Usage {
+        std::size_t bytes;
+        std::size_t budget;
+        std::size_t ids;
+        std::size_t pages;
+        std::uint64_t evicted_ids;
+        std::uint64_t evicted_pages;
+        AtlasOct::Counters traffic;
+    };
+
+    class Lease {
+    public:
+        ~Lease() noexcept { owner->settle(*ptr, base); }
+
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        [[nodiscard]] AtlasOct &atlas() const noexcept { return *ptr; }
+        [[nodiscard]] History &history() const noexcept { return *hist; }
+
+    private:
+        friend class GeoCache;
+
+        std::unique_lock<std::mutex> lock;
+        GeoCache *owner;
+        AtlasOct *ptr;
+        History *hist;
+        std::size_t base;
+
+        Lease(std::unique_lock<std::mutex> lock_, GeoCache *owner_, AtlasOct *ptr_, History *hist_) noexcept :
+            lock(std::move(lock_)), owner(owner_), ptr(ptr_), hist(hist_), base(ptr_->bytes()) {}
+    };
+
+    GeoCache() = default;
+
+    GeoCache(const GeoCache &) = delete;
+    GeoCache &operator=(const GeoCache &) = delete;
+
+    // Atlas and transform history of name holding id in scene, created on first use. Ids are only unique within a
+    // project and scene, which scene names; an empty scene is kept in memory only.
+    [[nodiscard]] Lease acquire(const std::string &name, const std::string &scene, int id);
+
+    // Drops every id of name in every scene, one shard at a time. Histories go too, and every memoized result, which
+    // are not keyed by name.
+    void clear(const std::string &name);
+
+    // Drops everything.
+    void clear();
+
+    // Keeps the history of every script and scene in a directory under root, so it outlives the process. Call before
+    // first use.
+    void persist(const std::filesystem::path &root_) { root = root_; }
+
+    // Byte budget of all atlases together; 0 is unlimited.
+    void set_budget(std::size_t size) noexcept { budget.store(size, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool is_over_budget() const noexcept {
+        const std::size_t limit = budget.load(std::memory_order_relaxed);
+        return limit && bytes.load(std::memory_order_relaxed) > limit;
+    }
+
+    [[nodiscard]] Usage usage();
+
+    // Bytes held per script name, or per id of one name, each over all scenes.
+    [[nodiscard]] std::vector<std::pair<std::string, std::size_t>> bytes_by_name();
+    [[nodiscard]] std::vector<std::pair<int, std::size_t>> bytes_by_id(const std::string &name);
+
+    [[nodiscard]] Stats &stats() noexcept { return counters; }
+    [[nodiscard]] Governor &governor() noexcept { return preview; }
+    [[nodiscard]] Memo &memo() noexcept { return results; }
+
+    // Evicts pages and ids about least recently used first, down to 7/8 of the budget besides the hash tables.
+    // Concurrent calls return at once, as do calls until usage has grown by an eighth of the budget past where the last
+    // trim ended.
+    void trim();
+
+private:
+    // Per script name, then per scene.
+    template <typename T>
+    using Scripts = std::unordered_map<std::string, std::unordered_map<std::string, T>>;
+
+    struct Shard {
+        std::mutex mutex;
+        Scripts<AtlasOct> atlases;
+        Scripts<History> histories;
+        std::uint64_t swept = 0;  // Clock at the last visit of the trim hand.
+    };
+
+    std::array<Shard, shards> table{};
+    std::filesystem::path root{};
+    std::atomic<std::size_t> bytes = 0;
+    std::atomic<std::size_t> budget = 0;
+    std::atomic<std::uint64_t> clock = 0;
+    std::atomic<std::uint64_t> evicted_ids = 0;
+    std::atomic<std::uint64_t> evicted_pages = 0;
+    std::mutex trimming;
+    std::size_t hand = 0;
+    std::size_t settled = 0;
+    Stats counters;
+    Governor preview;
+    Memo results;
+
+    [[nodiscard]] static constexpr std::size_t index(int id) noexcept {
+        return static_cast<std::size_t>(static_cast<unsigned>(id)) % shards;
+    }
+
+    // Carries the change in bytes of atlas since base into the total. Unsigned wrap-around makes shrinking work too.
+    void settle(const AtlasOct &atlas, std::size_t base) noexcept {
+        bytes.fetch_add(atlas.bytes() - base, std::memory_order_relaxed);
+    }
+};
@@ -1,20 +1,35 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <bitset>
+#include <cmath>
 #include <cstddef>
-#include <map>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
 #include <unordered_map>
 #include <vector>
 
+#include "store.hpp"
 #include "transform.hpp"
 
 template <std::size_t N>
 class Atlas {
 public:
-    constexpr Atlas() noexcept = default;
-    constexpr ~Atlas() noexcept = default;
+    Atlas() noexcept = default;
+    ~Atlas() noexcept = default;
 
-    constexpr void resize(int id, int idx, int num, int mode) {
+    Atlas(const Atlas &) = delete;
+    Atlas &operator=(const Atlas &) = delete;
+
+    void resize(int id, int idx, int num, int mode) {
         if (mode == 0) {
             if (storage.find(id) != storage.end())
                 clear(id);
@@ -22,109 +37,563 @@ public:
             return;
         }
 
-        auto &chunk = storage[id];
-        std::size_t size = chunk.size();
+        auto [it, fresh] = storage.try_emplace(id);
+        auto &entry = it->second;
+        if (fresh)
+            add(entry, node_bytes, 0);
 
-        if (num < size) {
-            std::vector<Block> temp(chunk.begin(), chunk.begin() + num);
-            chunk.swap(temp);
-        } else if (num > size) {
-            chunk.resize(num);
-        }
+        cursor = {id, &entry};
+        entry.stamp = now;
+
+        if (!dir.empty())
+            attach(id, entry, num);
+
+        // Tracks cut off by a smaller num go a few per call, fast enough to be gone within num calls, about a frame.
+        auto &chunk = entry.chunk;
+        add(entry, chunk.resize(num), 0);
+        release(entry, chunk.pace());
+        if (idx < 0 || idx >= chunk.size())
+            throw std::out_of_range("Index out of range.");
 
-        auto &block = chunk.at(idx);
+        auto &track = use(entry, idx);
 
-        if (mode == 1 || block.size() == 1)
+        if (mode == 1 || (track.base == 0 && track.pages.size() <= 1))
             return;
 
-        if (auto it = block.find(0); it != block.end()) {
-            auto node = block.extract(it);
-            Block{}.swap(block);
-            block.insert(std::move(node));
-        }
+        // Minimal keeps the first page only.
+        drop(entry, track);
+        if (track.base != 0)
+            track.pages.clear();
+
+        track.base = 0;
+        track.pages.resize(std::min<std::size_t>(track.pages.size(), 1));
+        track.pages.shrink_to_fit();
+        add(entry, track.bytes(), track.count());
     }
 
-    constexpr void write(int id, int idx, int pos, const Geo &geo) noexcept {
+    // Keeps a geo of the same frame already there, so a render repeating the frame Minimal holds at position 1 does not
+    // replace it.
+    void write(int id, int idx, int pos, const Geo &geo) noexcept {
         const auto [key, offset] = split_pos(pos);
 
-        auto it = storage.find(id);
-        if (it == storage.end())
-            return;
-
-        auto &chunk = it->second;
-        if (idx >= chunk.size())
-            return;
+        if (auto page = acquire(id, idx, key)) {
+            if (page->valid[offset] && page->frame == geo.get_frame())
+                return;
 
-        auto &unit = chunk[idx][key];
+            page->frame = geo.get_frame();
+            count_write(*page, offset);
+            if (page->set(offset, geo) && cursor.entry->file)
+                cursor.entry->file->write(idx, pos, geo);
+        }
+    }
 
-        if (unit[offset].is_cached(geo))
-            return;
+    void overwrite(int id, int idx, int pos, const Geo &geo) noexcept {
+        const auto [key, offset] = split_pos(pos);
 
-        unit[offset] = geo;
+        if (auto page = acquire(id, idx, key)) {
+            count_write(*page, offset);
+            page->set(offset, geo);
+            if (cursor.entry->file)
+                cursor.entry->file->write(idx, pos, geo);
+        }
     }
 
-    constexpr void overwrite(int id, int idx, int pos, const Geo &geo) noexcept {
+    // Misses fall through to the file, if any, and are paged back in. The frame is implied by pos, as pos - 1.
+    [[nodiscard]] std::optional<Geo> read(int id, int idx, int pos) noexcept {
         const auto [key, offset] = split_pos(pos);
 
-        auto it = storage.find(id);
-        if (it == storage.end())
-            return;
+        if (auto page = fetch(id, idx, key); page && page->valid[offset]) {
+            ++traffic.hits;
+            return page->get(pos - 1, offset);
+        }
 
-        auto &chunk = it->second;
-        if (idx >= chunk.size())
-            return;
+        if (auto entry = locate(id); entry && entry->file) {
+            if (auto geo = entry->file->read(idx, pos)) {
+                if (auto page = acquire(id, idx, key)) {
+                    ++traffic.file_hits;
+                    page->set(offset, *geo);
+                    return page->get(pos - 1, offset);
+                }
+            }
+        }
 
-        auto &unit = chunk[idx][key];
+        ++traffic.misses;
+        return std::nullopt;
+    }
 
-        unit[offset] = geo;
+    // Also deletes the files, unlike eviction.
+    void clear() noexcept {
+        Storage{}.swap(storage);
+        cursor = {};
+        total = 0;
+        pages = 0;
+
+        if (!dir.empty()) {
+            std::error_code ec;
+            std::filesystem::remove_all(dir, ec);
+            std::filesystem::create_directories(dir, ec);
+        }
     }
 
-    [[nodiscard]] constexpr const Geo *read(int id, int idx, int pos) const noexcept {
-        const auto [key, offset] = split_pos(pos);
+    void clear(int id) noexcept {
+        if (cursor.id == id)
+            cursor = {};
 
-        if (auto unit = fetch(id, idx, key); unit && (*unit)[offset].is_valid())
-            return &(*unit)[offset];
-        else
-            return nullptr;
+        if (auto it = storage.find(id); it != storage.end()) {
+            total -= it->second.bytes;
+            pages -= it->second.pages;
+            storage.erase(it);
+        }
+
+        if (!dir.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(path(id), ec);
+        }
     }
 
-    constexpr void clear() noexcept { Storage{}.swap(storage); }
+    // Backs every id with a GeoFile in dir from now on, stamped with the key of scene. Evicted ids keep their files and
+    // read them back lazily.
+    void persist(const std::filesystem::path &dir_, std::uint64_t scene_) noexcept {
+        std::error_code ec;
+        if (std::filesystem::create_directories(dir_, ec); !ec) {
+            dir = dir_;
+            scene = scene_;
+        }
+    }
 
-    constexpr void clear(int id) noexcept {
+    // Stamp given to everything accessed from now on; larger is more recent.
+    void set_time(std::uint64_t t) noexcept { now = t; }
+
+    // Heap bytes held: pages, page tables, tracks and hash nodes, whose overhead is taken as two pointers.
+    [[nodiscard]] std::size_t bytes() const noexcept { return total + table_bytes(); }
+    [[nodiscard]] std::size_t bytes(int id) const noexcept {
         auto it = storage.find(id);
-        if (it == storage.end())
-            return;
+        return it == storage.end() ? 0 : it->second.bytes;
+    }
+
+    // Part of bytes() in the buckets of the hash table, which keeps its size as ids go.
+    [[nodiscard]] std::size_t table_bytes() const noexcept { return storage.bucket_count() * sizeof(void *); }
+
+    [[nodiscard]] std::size_t ids() const noexcept { return storage.size(); }
+    [[nodiscard]] std::size_t page_count() const noexcept { return pages; }
+
+    [[nodiscard]] static constexpr std::size_t page_bytes() noexcept { return sizeof(Page); }
 
-        auto &chunk = it->second;
-        std::vector<Block>{}.swap(chunk);
-        storage.erase(id);
+    // Traffic since construction: reads served from memory, from the file or not at all, and writes, counting those
+    // that replaced a valid geo as overwrites too.
+    struct Counters {
+        std::uint64_t hits = 0;
+        std::uint64_t file_hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t writes = 0;
+        std::uint64_t overwrites = 0;
+    };
+
+    [[nodiscard]] const Counters &counters() const noexcept { return traffic; }
+
+    // fn(id, bytes) for every id.
+    template <typename F>
+    void for_each_id(F &&fn) const {
+        for (const auto &[id, entry] : storage) fn(id, entry.bytes);
+    }
+
+    // fn(stamp) for every page, including those of indices not reclaimed yet.
+    template <typename F>
+    void for_each_page(F &&fn) const {
+        for (const auto &[_, entry] : storage)
+            for (int i = 0; i < entry.chunk.capacity(); ++i)
+                for (const auto &page : entry.chunk[i].pages)
+                    if (page)
+                        fn(page->stamp);
+    }
+
+    // Drops every id last used before cutoff, then every page last used before it and the tracks past num still held.
+    // Returns the ids and pages dropped.
+    std::array<std::size_t, 2> evict(std::uint64_t cutoff) noexcept {
+        std::array<std::size_t, 2> count{};
+        for (auto it = storage.begin(); it != storage.end();) {
+            auto &entry = it->second;
+            if (entry.stamp < cutoff) {
+                if (cursor.entry == &entry)
+                    cursor = {};
+
+                count[1] += entry.pages;
+                total -= entry.bytes;
+                pages -= entry.pages;
+                it = storage.erase(it);
+                ++count[0];
+                continue;
+            }
+
+            auto &chunk = entry.chunk;
+            count[1] += release(entry, chunk.capacity());
+            for (int i = 0; i < chunk.size(); ++i) {
+                auto &track = chunk[i];
+                const std::size_t count_before = track.count();
+                drop(entry, track);
+
+                if (chunk.stale(i)) {
+                    chunk.reset(i);
+                    count[1] += count_before;
+                    continue;
+                }
+
+                for (auto &page : track.pages)
+                    if (page && page->stamp < cutoff)
+                        page.reset();
+
+                // Old frames go first, so the table is trimmed from the front as well as the back.
+                auto &v = track.pages;
+                const auto first = std::ranges::find_if(v, [](const auto &p) { return p != nullptr; });
+                const auto lead = static_cast<int>(first - v.begin());
+                if (first == v.end()) {
+                    chunk.reset(i);
+                } else {
+                    v.erase(v.begin(), first);
+                    while (!v.back()) v.pop_back();
+                    track.base += lead;
+                }
+                if (v.capacity() > v.size() * 2)
+                    v.shrink_to_fit();
+
+                count[1] += count_before - track.count();
+                add(entry, track.bytes(), track.count());
+            }
+            ++it;
+        }
+        return count;
     }
 
 private:
-    using Unit = std::array<Geo, N>;
-    using Block = std::map<int, Unit>;
-    using Storage = std::unordered_map<int, std::vector<Block>>;
-    Storage storage{};
+    // N consecutive positions, each stored as 32-bit multiples of unit off base, the first geo written. A geo decodes
+    // within unit / 2 and equal geos decode equal, so a still object stays still. unit is 2^-16 until a geo lands 2^15
+    // off base, when it doubles and the page is requantized: the geos held round once more, so those written before
+    // stay within unit only, and may decode apart from equal ones written after.
+    struct Page {
+        static constexpr double min_unit = 1.0 / 65536.0;
+
+        std::bitset<N> valid;
+        double unit = min_unit;
+        std::array<double, 7> base{};
+        std::array<std::array<std::int32_t, 7>, N> offsets{};
+        std::uint64_t stamp = 0;
+        std::int32_t frame = -1;  // Of the geo last given to write(), which only Minimal uses, at position 1.
+
+        [[nodiscard]] Geo get(int frame, std::size_t i) const noexcept {
+            const auto &q = offsets[i];
+            return Geo(frame, base[0] + q[0] * unit, base[1] + q[1] * unit, base[2] + q[2] * unit,
+                       base[3] + q[3] * unit, base[4] + q[4] * unit, base[5] + q[5] * unit, base[6] + q[6] * unit);
+        }
+
+        // Returns whether anything changed. A geo that cannot be encoded is dropped.
+        bool set(std::size_t i, const Geo &geo) noexcept {
+            if (!geo.is_valid() || !std::isfinite(geo[0] + geo[1] + geo[2] + geo[3] + geo[4] + geo[5] + geo[6])) {
+                const bool was = valid[i];
+                valid[i] = false;
+                return was;
+            }
+
+            if (valid.none()) {
+                for (std::size_t j = 0; j < base.size(); ++j) base[j] = geo[j];
+                unit = min_unit;
+            }
+
+            std::array<std::int32_t, 7> q{};
+            while (!quantize(geo, q)) {
+                // Offsets are whole, so halving leaves a tie or nothing: decoded geos move by the old unit at most.
+                for (std::size_t k = 0; k < N; ++k)
+                    if (valid[k])
+                        for (auto &v : offsets[k]) v = static_cast<std::int32_t>(std::floor(v * 0.5 + 0.5));
+                unit *= 2.0;
+            }
+
+            if (valid[i] && offsets[i] == q)
+                return false;
+
+            valid[i] = true;
+            offsets[i] = q;
+            return true;
+        }
+
+        [[nodiscard]] bool quantize(const Geo &geo, std::array<std::int32_t, 7> &q) const noexcept {
+            for (std::size_t j = 0; j < q.size(); ++j) {
+                const double v = std::floor((geo[j] - base[j]) / unit + 0.5);
+                if (!(std::abs(v) < 2147483647.0))
+                    return false;
+
+                q[j] = static_cast<std::int32_t>(v);
+            }
+            return true;
+        }
+    };
+
+    // Page table of one individual object: pages[k] holds pos / N == base + k. epoch is that of its last reset.
+    struct Track {
+        int base = 0;
+        std::uint32_t epoch = 0;
+        std::vector<std::unique_ptr<Page>> pages;
+
+        [[nodiscard]] std::size_t count() const noexcept {
+            return static_cast<std::size_t>(std::ranges::count_if(pages, [](const auto &p) { return p != nullptr; }));
+        }
+
+        [[nodiscard]] std::size_t bytes() const noexcept {
+            return pages.capacity() * sizeof(std::unique_ptr<Page>) + count() * sizeof(Page);
+        }
+    };
+
+    // Tracks of indices [0, size()) in segments that never move, so a change of num costs O(1) amortized. Segment k
+    // holds indices [first * 2^(k - 1), first * 2^k), segment 0 the first ones. A shrink only records where it cut:
+    // the tracks left past it are stale. Those past size() are released from the top a pace at a time; those a regrowth
+    // brought back are reset by their next use or by evict().
+    class Chunk {
+    public:
+        static constexpr int first = 8;
+
+        [[nodiscard]] int size() const noexcept { return count; }
+        [[nodiscard]] int capacity() const noexcept { return reach(segments.size()); }
+
+        // Tracks to release per call so that those past size() go within size() calls.
+        [[nodiscard]] int pace() const noexcept { return step; }
+
+        [[nodiscard]] Track &operator[](int i) noexcept {
+            const auto [k, j] = split(i);
+            return segments[k][j];
+        }
+        [[nodiscard]] const Track &operator[](int i) const noexcept {
+            const auto [k, j] = split(i);
+            return segments[k][j];
+        }
+
+        // Returns the bytes of the segments added.
+        std::size_t resize(int num) {
+            num = std::max(num, 0);
+            if (num < count) {
+                // A later cut at or below an earlier one supersedes it, so sizes and epochs both rise up the stack.
+                ++epoch;
+                while (!cuts.empty() && cuts.back().size >= num) cuts.pop_back();
+                cuts.push_back({num, epoch});
+                step = std::max(first, (extent - num + std::max(num, 1) - 1) / std::max(num, 1));
+            }
+
+            std::size_t added = 0;
+            while (capacity() < num) {
+                const int len = length(segments.size());
+                auto &seg = segments.emplace_back(std::make_unique<Track[]>(len));
+                for (int j = 0; j < len; ++j) seg[j].epoch = epoch;
+                added += bytes(len);
+            }
+            count = num;
+            extent = std::max(extent, num);
+            return added;
+        }
 
-    [[nodiscard]] constexpr std::array<int, 2> split_pos(int pos) const noexcept {
+        // Resets up to limit of the tracks past size(), from the top, handing each to fn first, then frees the segments
+        // they emptied. Returns the bytes freed.
+        template <typename F>
+        std::size_t release(int limit, F &&fn) noexcept {
+            for (; limit > 0 && extent > count; --limit) {
+                --extent;
+                fn((*this)[extent]);
+                reset(extent);
+            }
+
+            std::size_t freed = 0;
+            while (!segments.empty() && reach(segments.size() - 1) >= extent) {
+                freed += bytes(length(segments.size() - 1));
+                segments.pop_back();
+            }
+            return freed;
+        }
+
+        // Whether a shrink cut index i off since the last reset of its track.
+        [[nodiscard]] bool stale(int i) const noexcept {
+            const auto it = std::ranges::upper_bound(cuts, i, {}, &Cut::size);
+            return it != cuts.begin() && (*this)[i].epoch < std::prev(it)->epoch;
+        }
+
+        void reset(int i) noexcept {
+            auto &track = (*this)[i];
+            track = Track{};
+            track.epoch = epoch;
+        }
+
+    private:
+        struct Cut {
+            int size;
+            std::uint32_t epoch;
+        };
+
+        std::vector<std::unique_ptr<Track[]>> segments;
+        std::vector<Cut> cuts;
+        int count = 0;
+        // Indices past it hold empty tracks.
+        int extent = 0;
+        int step = first;
+        std::uint32_t epoch = 0;
+
+        // Length of segment k, and the indices held by the first n segments.
+        [[nodiscard]] static constexpr int length(std::size_t k) noexcept { return k ? first << (k - 1) : first; }
+        [[nodiscard]] static constexpr int reach(std::size_t n) noexcept { return n ? first << (n - 1) : 0; }
+
+        [[nodiscard]] static constexpr std::size_t bytes(int len) noexcept {
+            return len * sizeof(Track) + sizeof(std::unique_ptr<Track[]>);
+        }
+
+        [[nodiscard]] static constexpr std::array<int, 2> split(int i) noexcept {
+            const int k = std::bit_width(static_cast<unsigned>(i / first));
+            return {k, k ? i - (first << (k - 1)) : i};
+        }
+    };
+
+    struct Entry {
+        Chunk chunk;
+        std::unique_ptr<GeoFile> file;
+        std::size_t bytes = 0;
+        std::size_t pages = 0;
+        std::uint64_t stamp = 0;
+    };
+
+    using Storage = std::unordered_map<int, Entry>;
+
+    static constexpr std::size_t node_bytes = sizeof(typename Storage::value_type) + 2 * sizeof(void *);
+
+    // Last id looked up. Nodes of unordered_map are stable, so this stays valid until the id is erased.
+    struct Cursor {
+        int id = 0;
+        Entry *entry = nullptr;
+    };
+
+    Storage storage{};
+    std::filesystem::path dir{};
+    std::uint64_t scene = 0;
+    mutable Cursor cursor{};
+    std::size_t total = 0;
+    std::size_t pages = 0;
+    std::uint64_t now = 0;
+    Counters traffic{};
+
+    [[nodiscard]] static constexpr std::array<int, 2> split_pos(int pos) noexcept {
         constexpr int size = static_cast<int>(N);
         return {pos / size, pos % size};
     }
 
-    [[nodiscard]] constexpr const Unit *fetch(int id, int idx, int key) const noexcept {
-        auto it_id = storage.find(id);
-        if (it_id == storage.end())
+    void count_write(const Page &page, std::size_t offset) noexcept {
+        ++traffic.writes;
+        traffic.overwrites += page.valid[offset] ? 1 : 0;
+    }
+
+    void add(Entry &entry, std::size_t size, std::size_t count) noexcept {
+        entry.bytes += size;
+        entry.pages += count;
+        total += size;
+        pages += count;
+    }
+
+    // Releases the accounting of a track that is about to be dropped or rebuilt.
+    void drop(Entry &entry, const Track &track) noexcept {
+        const std::size_t count = track.count();
+        const std::size_t size = track.bytes();
+        entry.bytes -= size;
+        entry.pages -= count;
+        total -= size;
+        pages -= count;
+    }
+
+    // Releases up to limit tracks past num and the segments they empty. Returns the pages dropped.
+    std::size_t release(Entry &entry, int limit) noexcept {
+        std::size_t count = 0;
+        const std::size_t freed = entry.chunk.release(limit, [&](const Track &track) {
+            count += track.count();
+            drop(entry, track);
+        });
+        entry.bytes -= freed;
+        total -= freed;
+        return count;
+    }
+
+    // Track of idx, reset first if a shrink cut it off since its last use.
+    Track &use(Entry &entry, int idx) noexcept {
+        if (entry.chunk.stale(idx)) {
+            drop(entry, entry.chunk[idx]);
+            entry.chunk.reset(idx);
+        }
+        return entry.chunk[idx];
+    }
+
+    [[nodiscard]] std::filesystem::path path(int id) const { return dir / (std::to_string(id) + ".geo"); }
+
+    // Opens the file of id on first use; a file that cannot be opened leaves the id in memory only.
+    void attach(int id, Entry &entry, int num) {
+        if (!entry.file) {
+            auto file = std::make_unique<GeoFile>(path(id), id, scene, num);
+            if (file->is_open()) {
+                entry.file = std::move(file);
+                add(entry, sizeof(GeoFile), 0);
+            }
+        } else {
+            entry.file->resize(num);
+        }
+    }
+
+    [[nodiscard]] Entry *locate(int id) const noexcept {
+        if (cursor.entry && cursor.id == id)
+            return cursor.entry;
+
+        auto it = storage.find(id);
+        if (it == storage.end())
             return nullptr;
 
-        auto &chunk = it_id->second;
-        if (idx >= chunk.size())
+        cursor = {id, const_cast<Entry *>(&it->second)};
+        return cursor.entry;
+    }
+
+    [[nodiscard]] Page *acquire(int id, int idx, int key) noexcept {
+        auto entry = locate(id);
+        if (!entry || idx < 0 || idx >= entry->chunk.size() || key < 0)
             return nullptr;
 
-        auto &block = chunk[idx];
-        auto it_key = block.find(key);
-        if (it_key == block.end())
+        auto &track = use(*entry, idx);
+        auto &v = track.pages;
+        const std::size_t cap = v.capacity();
+        if (v.empty()) {
+            track.base = key;
+            v.resize(1);
+        } else if (key < track.base) {
+            std::vector<std::unique_ptr<Page>> grown(v.size() + (track.base - key));
+            std::ranges::move(v, grown.begin() + (track.base - key));
+            v.swap(grown);
+            track.base = key;
+        } else if (key - track.base >= static_cast<int>(v.size())) {
+            v.resize(key - track.base + 1);
+        }
+        add(*entry, (v.capacity() - cap) * sizeof(std::unique_ptr<Page>), 0);
+
+        auto &page = v[key - track.base];
+        if (!page) {
+            page = std::make_unique<Page>();
+            add(*entry, sizeof(Page), 1);
+        }
+
+        entry->stamp = now;
+        page->stamp = now;
+        return page.get();
+    }
+
+    [[nodiscard]] const Page *fetch(int id, int idx, int key) const noexcept {
+        auto entry = locate(id);
+        if (!entry || idx < 0 || idx >= entry->chunk.size() || entry->chunk.stale(idx))
             return nullptr;
 
-        return &it_key->second;
+        const auto &track = entry->chunk[idx];
+        if (key < track.base || key - track.base >= static_cast<int>(track.pages.size()))
+            return nullptr;
+
+        if (const auto &page = track.pages[key - track.base]) {
+            entry->stamp = now;
+            page->stamp = now;
+            return page.get();
+        }
+        return nullptr;
     }
 };
@@ -0,0 +1,75 @@
+#include "governor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+int
+Governor::admit(const Context &context, const Demand &demand, double budget) {
+    if (budget <= 0.0)
+        return demand.smp;
+
+    const std::size_t key = std::hash<std::string>{}(context.name) ^
+                            (static_cast<std::size_t>(context.id) * 0x9e3779b97f4a7c15ull) ^
+                            (static_cast<std::size_t>(context.idx) << 1);
+
+    std::scoped_lock lock(mutex);
+    if ((context.tick && context.tick != tick) || seen.contains(key)) {
+        // Demand rising since the frame before is expected to keep rising as much. Shares rise with the weights too,
+        // since they are taken relative to this frame's lightest, so the cost goes with the square.
+        double total = 0.0;
+        for (const auto &d : demands) total += d.smp * d.area;
+        const double growth = last > 0.0 ? std::clamp(total / last, 1.0, 2.0) : 1.0;
+
+        factor = solve(demands, budget / (growth * growth));
+        if (!demands.empty())
+            lightest = std::ranges::min(demands, {}, &Demand::weight).weight;
+        last = total;
+        tick = context.tick ? context.tick : tick;
+        seen.clear();
+        demands.clear();
+    }
+
+    seen.insert(key);
+    demands.push_back({demand.smp, demand.weight, std::max(demand.area, 1.0)});
+    const int kept = static_cast<int>(std::ceil(demand.smp * share(factor, demand.weight, lightest)));
+    return std::min(std::max(kept, floor), demand.smp);
+}
+
+double
+Governor::scale() const {
+    std::scoped_lock lock(mutex);
+    return factor;
+}
+
+double
+Governor::share(double k, double weight, double lightest) noexcept {
+    return k >= 1.0 ? 1.0 : std::min(k * weight / std::max(lightest, 1.0), 1.0);
+}
+
+double
+Governor::solve(const std::vector<Demand> &demands, double budget) noexcept {
+    if (demands.empty())
+        return 1.0;
+
+    const double lightest = std::ranges::min(demands, {}, &Demand::weight).weight;
+    auto cost = [&](double k) {
+        double sum = 0.0;
+        for (const auto &[smp, weight, area] : demands)
+            sum += std::max(static_cast<double>(std::min(smp, floor)), smp * share(k, weight, lightest)) * area;
+        return sum;
+    };
+
+    if (cost(1.0) <= budget)
+        return 1.0;
+
+    if (cost(0.0) >= budget)
+        return 0.0;
+
+    double lo = 0.0, hi = 1.0;
+    for (int i = 0; i < 32; ++i) {
+        const double mid = (lo + hi) * 0.5;
+        (cost(mid) <= budget ? lo : hi) = mid;
+    }
+    return lo;
+}
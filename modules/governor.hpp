@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "structs.hpp"
+
+// Spreads a per-frame budget of samples x pixels over the objects of a preview. A frame ends when the timeline frame
+// (Context::tick) changes or an object comes round again; the next one is admitted with the scale solved from its
+// demands and how fast they grew, so a cut lags one frame behind. Context::frame counts from the start of each object,
+// so it cannot tell frames apart.
+class Governor {
+public:
+    // Objects keep at least this many samples, or all they ask for when that is less.
+    static constexpr int floor = 4;
+
+    struct Demand {
+        // smp + 1 the object would get without a budget.
+        int smp;
+        // req_smp + 1, what its motion asks for before any limit.
+        double weight;
+        // Pixels the blur runs over.
+        double area;
+    };
+
+    Governor() = default;
+
+    Governor(const Governor &) = delete;
+    Governor &operator=(const Governor &) = delete;
+
+    // Samples the object may take out of demand.smp. budget is in samples x pixels per frame; 0 admits everything.
+    [[nodiscard]] int admit(const Context &context, const Demand &demand, double budget);
+
+    // Scale applied to the current frame.
+    [[nodiscard]] double scale() const;
+
+    // Share of its samples an object keeps at scale k: min(1, k * weight / lightest), lightest being the smallest
+    // weight of the frame solved. The lightest objects are cut first and the heaviest last; k = 1 cuts nothing.
+    [[nodiscard]] static double share(double k, double weight, double lightest) noexcept;
+
+    // Largest k at which every object keeps max(min(smp, floor), smp * share) samples within budget.
+    [[nodiscard]] static double solve(const std::vector<Demand> &demands, double budget) noexcept;
+
+private:
+    mutable std::mutex mutex;
+    int tick = 0;
+    double factor = 1.0;
+    double lightest = 1.0;
+    double last = 0.0;
+    std::unordered_set<std::size_t> seen;
+    std::vector<Demand> demands;
+};
@@ -0,0 +1,53 @@
+#include "history.hpp"
+
+void
+History::record(int id, int idx, int num, int frame, const Transform &xform) {
+    if (idx < 0 || idx >= num)
+        return;
+
+    auto &slots = storage[id];
+    if (static_cast<int>(slots.size()) != num)
+        slots.resize(num);
+
+    auto &slot = slots[idx];
+    slot.frame = frame;
+    slot.last = xform;
+    ++slot.seq;
+    if (frame == 1 || frame == 2) {
+        slot.lead[frame - 1] = xform;
+        slot.lead_seq[frame - 1] = slot.seq;
+    }
+}
+
+std::optional<Transform>
+History::prev(int id, int idx, int frame, int ext, const Transform &curr) const noexcept {
+    if (frame == 0 && ext == 0)
+        return curr;
+
+    auto it = storage.find(id);
+    if (it == storage.end() || idx < 0 || idx >= static_cast<int>(it->second.size()))
+        return std::nullopt;
+
+    const auto &slot = it->second[idx];
+    if (frame > 0) {
+        if (slot.frame == frame - 1)
+            return slot.last;
+
+        return std::nullopt;
+    }
+
+    // Frame 1 must be the last call, and for ext 2 frame 2 the one before it.
+    if (!slot.lead_seq[0] || slot.lead_seq[0] != slot.seq)
+        return std::nullopt;
+
+    if (ext == 1) {
+        Transform xform;
+        for (std::size_t i = 0; i < 7; ++i) xform[i] = curr[i] * 2.0 - slot.lead[0][i];
+        return xform;
+    } else if (ext == 2 && slot.lead_seq[1] && slot.lead_seq[1] + 1 == slot.seq) {
+        Transform xform;
+        for (std::size_t i = 0; i < 7; ++i) xform[i] = curr[i] * 3.0 - slot.lead[0][i] * 3.0 + slot.lead[1][i];
+        return xform;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "transform.hpp"
+
+// Track-bar transforms seen for every object index, so the previous one can come from the module instead of
+// obj.getvalue. Holds the last frame rendered and frames 1 and 2, which frame 0 extrapolates from only when they were
+// the calls right before it, as when playing backwards. Leads of an earlier render may predate an edit.
+class History {
+public:
+    // Call with the current transform before looking up the next frame.
+    void record(int id, int idx, int num, int frame, const Transform &xform);
+
+    // Transform of frame - 1: the one recorded by the last call when that was for frame - 1, or at frame 0 the one
+    // extrapolated like Geo by ext from the frames the last ext calls recorded. std::nullopt when the history does not
+    // have it.
+    [[nodiscard]] std::optional<Transform> prev(int id, int idx, int frame, int ext,
+                                                const Transform &curr) const noexcept;
+
+    void clear() noexcept { storage.clear(); }
+    void clear(int id) noexcept { storage.erase(id); }
+
+private:
+    struct Slot {
+        int frame = -1;
+        std::uint64_t seq = 0;
+        Transform last;
+        std::array<Transform, 2> lead;
+        // seq of the call that recorded each lead; 0 for none.
+        std::array<std::uint64_t, 2> lead_seq{};
+    };
+
+    std::unordered_map<int, std::vector<Slot>> storage;
+};
@@ -0,0 +1,199 @@
+#include "host.hpp"
+
+#include <cstring>
+#include <utility>
+
+static Host::Table
+to_table(const Param &param) {
+    return {{"amt", param.amt},
+            {"smp_lim", param.smp_lim},
+            {"smp_budget", param.smp_budget},
+            {"spacing", param.spacing},
+            {"doubling", param.doubling},
+            {"ext", param.ext},
+            {"geo_cache", param.geo_cache},
+            {"cache_purge", param.cache_purge},
+            {"cache_limit", param.cache_limit},
+            {"tile", param.tile},
+            {"mip_taps", param.mip_taps},
+            {"print_info", param.print_info}};
+}
+
+void
+Host::push_call(const Call &call, Geo *data, bool cached) {
+    const auto &[param, context, xform, geo, _] = call;
+
+    auto to_row = [](const char *const *keys, const auto &v) {
+        Table table;
+        for (std::size_t i = 0; i < 7; ++i) table.emplace_back(keys[i], v[i]);
+        return table;
+    };
+
+    constexpr const char *xform_keys[] = {"cx", "cy", "x", "y", "rz", "sx", "sy"};
+    constexpr const char *geo_keys[] = {"cx", "cy", "ox", "oy", "rz", "sx", "sy"};
+
+    push(to_table(param));
+    push(Table{{"name", context.name},
+               {"w", context.res.x()},
+               {"h", context.res.y()},
+               {"cx", context.pivot.x()},
+               {"cy", context.pivot.y()},
+               {"id", context.id},
+               {"idx", context.idx},
+               {"num", context.num},
+               {"frame", context.frame},
+               {"range", context.range},
+               {"tick", context.tick},
+               {"scene", context.scene}});
+    push(to_row(xform_keys, xform.curr));
+    push(cached ? Table{{"cached", true}} : to_row(xform_keys, xform.prev));
+    push(to_row(geo_keys, geo));
+
+    if (data) {
+        push(static_cast<void *>(data));
+        push(static_cast<int>(sizeof(Geo)));
+    }
+}
+
+void
+Host::push_batch(const std::vector<Call> &calls) {
+    if (calls.empty())
+        return;
+
+    const auto &[param, context, xform, geo, _] = calls.front();
+    push(to_table(param));
+    push(Table{{"name", context.name},
+               {"id", context.id},
+               {"num", static_cast<int>(calls.size())},
+               {"frame", context.frame},
+               {"range", context.range},
+               {"tick", context.tick},
+               {"scene", context.scene}});
+
+    Array curr, prev, geos, sizes;
+    for (const auto &call : calls) {
+        for (std::size_t i = 0; i < 7; ++i) {
+            curr.push_back(call.xform.curr[i]);
+            prev.push_back(call.xform.prev[i]);
+            geos.push_back(call.geo[i]);
+        }
+        sizes.insert(sizes.end(), {call.context.res.x(), call.context.res.y(), call.context.pivot.x(),
+                                   call.context.pivot.y()});
+    }
+
+    push(std::move(curr));
+    push(std::move(prev));
+    push(std::move(geos));
+    push(std::move(sizes));
+}
+
+int
+Host::get_param_int(int idx) const noexcept {
+    if (idx < 0 || idx >= get_param_num())
+        return 0;
+
+    auto v = std::get_if<int>(&args[idx]);
+    return v ? *v : 0;
+}
+
+void *
+Host::get_param_data(int idx) const noexcept {
+    if (idx < 0 || idx >= get_param_num())
+        return nullptr;
+
+    auto v = std::get_if<void *>(&args[idx]);
+    return v ? *v : nullptr;
+}
+
+const char *
+Host::get_param_string(int idx) const noexcept {
+    if (idx < 0 || idx >= get_param_num())
+        return nullptr;
+
+    auto v = std::get_if<std::string>(&args[idx]);
+    return v ? v->c_str() : nullptr;
+}
+
+// Numbers convert like lua_tointeger / lua_tonumber; anything but nil and false is true.
+int
+Host::get_param_table_int(int idx, const char *key) const noexcept {
+    return static_cast<int>(get_param_table_double(idx, key));
+}
+
+double
+Host::get_param_table_double(int idx, const char *key) const noexcept {
+    if (auto v = find(idx, key)) {
+        if (auto i = std::get_if<int>(v))
+            return static_cast<double>(*i);
+        else if (auto d = std::get_if<double>(v))
+            return *d;
+    }
+    return 0.0;
+}
+
+bool
+Host::get_param_table_boolean(int idx, const char *key) const noexcept {
+    if (auto v = find(idx, key)) {
+        auto b = std::get_if<bool>(v);
+        return !b || *b;
+    }
+    return false;
+}
+
+const char *
+Host::get_param_table_string(int idx, const char *key) const noexcept {
+    if (auto v = find(idx, key)) {
+        if (auto s = std::get_if<std::string>(v))
+            return s->c_str();
+    }
+    return nullptr;
+}
+
+int
+Host::get_param_array_num(int idx) const noexcept {
+    if (idx < 0 || idx >= get_param_num())
+        return 0;
+
+    auto v = std::get_if<Array>(&args[idx]);
+    return v ? static_cast<int>(v->size()) : 0;
+}
+
+double
+Host::get_param_array_double(int idx, int key) const noexcept {
+    if (idx < 0 || idx >= get_param_num())
+        return 0.0;
+
+    auto v = std::get_if<Array>(&args[idx]);
+    return v && key >= 0 && key < static_cast<int>(v->size()) ? (*v)[key] : 0.0;
+}
+
+void
+Host::push_result_table_double(const char **keys, double *values, int num) {
+    for (int i = 0; i < num; ++i) results.table.emplace_back(keys[i], values[i]);
+}
+
+void
+Host::push_result_array_int(int *values, int num) {
+    results.int_arrays.emplace_back(values, values + num);
+}
+
+void
+Host::push_result_array_double(double *values, int num) {
+    results.arrays.emplace_back(values, values + num);
+}
+
+const Host::Value *
+Host::find(int idx, const char *key) const noexcept {
+    if (idx < 0 || idx >= get_param_num())
+        return nullptr;
+
+    auto table = std::get_if<Table>(&args[idx]);
+    if (!table)
+        return nullptr;
+
+    for (const auto &[k, v] : *table)
+        if (std::strcmp(k.c_str(), key) == 0)
+            return &v;
+
+    return nullptr;
+}
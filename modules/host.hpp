@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "structs.hpp"
+
+// In-process stand-in for SCRIPT_MODULE_PARAM. Arguments are pushed like Lua values and results are collected in
+// call order, so the script marshalling in script.hpp can run without the host application.
+class Host {
+public:
+    using Value = std::variant<int, double, bool, std::string>;
+    using Table = std::vector<std::pair<std::string, Value>>;
+    using Array = std::vector<double>;
+    using Arg = std::variant<Table, void *, int, Array, std::string>;
+
+    struct Results {
+        std::vector<std::pair<std::string, double>> table;
+        std::vector<int> ints;
+        std::vector<std::vector<double>> arrays;
+        std::vector<std::vector<int>> int_arrays;
+        std::string error;
+    };
+
+    void clear() noexcept {
+        args.clear();
+        results = {};
+    }
+
+    void push(Arg arg) { args.push_back(std::move(arg)); }
+
+    // Pushes the arguments ObjectMotionBlur_LK.anm2 passes to compute_motion. cached leaves xform_prev to the module.
+    void push_call(const Call &call, Geo *data, bool cached = false);
+
+    // Pushes the arguments of compute_motion_batch for consecutive indices of one id, taken from calls.
+    void push_batch(const std::vector<Call> &calls);
+
+    [[nodiscard]] const Results &result() const noexcept { return results; }
+
+    // SCRIPT_MODULE_PARAM interface, with the parameter types of module2.h so calls the host rejects do not build.
+    [[nodiscard]] int get_param_num() const noexcept { return static_cast<int>(args.size()); }
+    [[nodiscard]] int get_param_int(int idx) const noexcept;
+    [[nodiscard]] void *get_param_data(int idx) const noexcept;
+    [[nodiscard]] const char *get_param_string(int idx) const noexcept;
+    [[nodiscard]] int get_param_table_int(int idx, const char *key) const noexcept;
+    [[nodiscard]] double get_param_table_double(int idx, const char *key) const noexcept;
+    [[nodiscard]] bool get_param_table_boolean(int idx, const char *key) const noexcept;
+    [[nodiscard]] const char *get_param_table_string(int idx, const char *key) const noexcept;
+    [[nodiscard]] int get_param_array_num(int idx) const noexcept;
+    [[nodiscard]] double get_param_array_double(int idx, int key) const noexcept;
+
+    void push_result_int(int value) { results.ints.push_back(value); }
+    void push_result_table_double(const char **keys, double *values, int num);
+    void push_result_array_int(int *values, int num);
+    void push_result_array_double(double *values, int num);
+    void set_error(const char *message) { results.error = message; }
+
+private:
+    std::vector<Arg> args;
+    Results results;
+
+    [[nodiscard]] const Value *find(int idx, const char *key) const noexcept;
+};
@@ -0,0 +1,148 @@
+#include "memo.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+Memo::Key
+Memo::key(const Param &param, const Context &context, const Flow &flow, int kind) noexcept {
+    Key key{};
+    auto &data = key.data;
+    std::size_t n = 0;
+    auto put = [&](const auto &v) {
+        for (std::size_t i = 0; i < 7; ++i) data[n++] = v[i];
+    };
+
+    put(flow.xform.curr);
+    put(flow.xform.prev);
+    put(*flow.geo.curr);
+    put(*flow.geo.prev);
+    data[n++] = context.res.x();
+    data[n++] = context.res.y();
+    data[n++] = context.pivot.x();
+    data[n++] = context.pivot.y();
+    data[n++] = param.amt;
+    data[n++] = param.spacing;
+    data[n++] = param.smp_lim;
+    data[n++] = param.doubling;
+    data[n++] = param.tile;
+    data[n++] = param.mip_taps;
+    data[n++] = kind;
+    key.hash = hash(data);
+    return key;
+}
+
+std::optional<Result>
+Memo::find(const Key &key) {
+    if (!capacity.load(std::memory_order_relaxed))
+        return std::nullopt;
+
+    const auto h = key.hash;
+    auto &shard = table[h % shards];
+
+    std::scoped_lock lock(shard.mutex);
+    auto it = shard.index.find(h);
+    if (it == shard.index.end() || std::memcmp(it->second.key.data.data(), key.data.data(), sizeof(key.data)) != 0) {
+        ++shard.misses;
+        return std::nullopt;
+    }
+
+    ++shard.hits;
+    it->second.used = ++shard.clock;
+    return it->second.result;
+}
+
+void
+Memo::insert(const Key &key, const Result &result) {
+    const auto h = key.hash;
+    const std::size_t limit = capacity.load(std::memory_order_relaxed) / shards;
+    const std::size_t bytes = sizeof(Entry) + sizeof(std::uint64_t) * 4 +
+                              result.passes.size() * sizeof(Mat3<double>) + result.taps.size() * sizeof(double) +
+                              result.tiles.smp.size() * sizeof(int);
+    if (bytes > limit || !is_offered(h))
+        return;
+
+    auto &shard = table[h % shards];
+    std::scoped_lock lock(shard.mutex);
+    if (auto it = shard.index.find(h); it != shard.index.end()) {
+        shard.bytes -= it->second.bytes;
+        shard.index.erase(it);
+    }
+
+    if (shard.bytes + bytes > limit) {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> ages;
+        ages.reserve(shard.index.size());
+        for (const auto &[k, entry] : shard.index) ages.emplace_back(entry.used, k);
+        std::ranges::sort(ages);
+
+        for (const auto &[_, k] : ages) {
+            if (shard.bytes + bytes <= limit / 8 * 7)
+                break;
+
+            auto it = shard.index.find(k);
+            shard.bytes -= it->second.bytes;
+            shard.index.erase(it);
+        }
+    }
+
+    shard.index.insert_or_assign(h, Entry{key, result, bytes, ++shard.clock});
+    shard.bytes += bytes;
+}
+
+void
+Memo::clear() {
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        shard.index.clear();
+        shard.bytes = 0;
+    }
+
+    for (auto &word : offered) word.store(0, std::memory_order_relaxed);
+    offers.store(0, std::memory_order_relaxed);
+}
+
+bool
+Memo::is_offered(std::uint64_t h) noexcept {
+    const std::array<std::size_t, 2> bits{(h >> 4) % marks, (h >> 24) % marks};
+    bool seen = true;
+    for (const auto bit : bits) {
+        const std::uint64_t mask = std::uint64_t{1} << (bit % 64);
+        seen &= (offered[bit / 64].fetch_or(mask, std::memory_order_relaxed) & mask) != 0;
+    }
+
+    if (!seen && offers.fetch_add(1, std::memory_order_relaxed) + 1 >= marks / 4) {
+        for (auto &word : offered) word.store(0, std::memory_order_relaxed);
+        offers.store(0, std::memory_order_relaxed);
+    }
+    return seen;
+}
+
+Memo::Counters
+Memo::counters() {
+    Counters c{};
+    for (auto &shard : table) {
+        std::scoped_lock lock(shard.mutex);
+        c.hits += shard.hits;
+        c.misses += shard.misses;
+        c.entries += shard.index.size();
+        c.bytes += shard.bytes;
+    }
+    return c;
+}
+
+// FNV-1a over the bit patterns, so keys hash equal exactly when they compare equal. Four interleaved lanes keep the
+// multiplies off one dependency chain; a splitmix64 finalizer mixes them into the low bits that pick the shard.
+std::uint64_t
+Memo::hash(const std::array<double, 39> &data) noexcept {
+    std::array<std::uint64_t, 4> lanes{0xcbf29ce484222325ull, 0x84222325cbf29ce4ull, 0x100000001b3ull, 0x1b3ull};
+    for (std::size_t i = 0; i < data.size(); i += 4)
+        for (std::size_t j = 0; j < 4 && i + j < data.size(); ++j)
+            lanes[j] = (lanes[j] ^ std::bit_cast<std::uint64_t>(data[i + j])) * 0x100000001b3ull;
+
+    std::uint64_t h = lanes[0] ^ std::rotl(lanes[1], 16) ^ std::rotl(lanes[2], 32) ^ std::rotl(lanes[3], 48);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
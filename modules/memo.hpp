@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "structs.hpp"
+
+// Results of compute() keyed by every input they depend on, so scrubbing over frames already rendered skips the
+// math. Sharded by key behind per-shard locks; a shard past its share of the capacity evicts its least recently used
+// results down to 7/8 of it. A result is stored only the second time its key is offered, so a straight render, which
+// never comes back, pays for no copies. Keys offered once are kept in a two-bit Bloom filter.
+class Memo {
+public:
+    static constexpr std::size_t shards = 16;
+    // Bits of the filter of keys offered once, cleared after marks / 4 new keys.
+    static constexpr std::size_t marks = 1 << 20;
+
+    // Transforms and geos of both frames, the object's size and pivot, amt, spacing, smp_lim, doubling, tile, mip_taps
+    // and kind.
+    struct Key {
+        std::array<double, 39> data;
+        std::uint64_t hash;
+    };
+
+    struct Counters {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::size_t entries;
+        std::size_t bytes;
+    };
+
+    Memo() = default;
+
+    Memo(const Memo &) = delete;
+    Memo &operator=(const Memo &) = delete;
+
+    // Call before flow.delta(), which folds the geos into the transforms. kind tells apart callers whose results
+    // are built differently from the same inputs.
+    [[nodiscard]] static Key key(const Param &param, const Context &context, const Flow &flow, int kind) noexcept;
+
+    // Bytes of results kept. 0 turns memoization off.
+    void set_capacity(std::size_t bytes) noexcept { capacity.store(bytes, std::memory_order_relaxed); }
+
+    [[nodiscard]] std::optional<Result> find(const Key &key);
+    void insert(const Key &key, const Result &result);
+    void clear();
+
+    [[nodiscard]] Counters counters();
+
+private:
+    struct Entry {
+        Key key;
+        Result result;
+        std::size_t bytes;
+        std::uint64_t used;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::uint64_t, Entry> index;
+        std::uint64_t clock = 0;
+        std::size_t bytes = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+    };
+
+    std::array<Shard, shards> table{};
+    std::atomic<std::size_t> capacity = 64 * 1048576;
+    std::array<std::atomic<std::uint64_t>, marks / 64> offered{};
+    std::atomic<std::size_t> offers = 0;
+
+    // True when key was offered before; marks it otherwise.
+    [[nodiscard]] bool is_offered(std::uint64_t h) noexcept;
+
+    [[nodiscard]] static std::uint64_t hash(const std::array<double, 39> &data) noexcept;
+};
@@ -0,0 +1,451 @@
+#include "motion.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+
+#include "pool.hpp"
+
+void
+extrapolate(AtlasOct &atlas, const Param &param, const Context &context, Flow &flow) noexcept {
+    bool valid = true;
+    std::array<Geo, 2> geos{};
+
+    for (int i = 0; i < param.ext; ++i) {
+        if (auto g = atlas.read(context.id, context.idx, i + 2))
+            geos[i] = *g;
+        else
+            valid = false;
+    }
+
+    if (valid) {
+        switch (param.ext) {
+            case 1:
+                atlas.overwrite(context.id, context.idx, 0, *flow.geo.curr * 2.0 - geos[0]);
+                break;
+            case 2:
+                atlas.overwrite(context.id, context.idx, 0, *flow.geo.curr * 3.0 - geos[0] * 3.0 + geos[1]);
+                break;
+            default:
+                atlas.overwrite(context.id, context.idx, 0, *flow.geo.curr);
+                break;
+        }
+
+        if (auto g = atlas.read(context.id, context.idx, 0)) {
+            flow.set_prev(*g);
+            flow.write_data(*g);
+        }
+    } else if (auto g = flow.read_data()) {
+        flow.geo.prev = g;
+    }
+}
+
+// Largest value over a step of a track through g0 and g1 whose second derivative is bounded: the parabola of curvature
+// k = bound * step^2 / 2 over the chord. Only a peak inside the step lifts it above the larger end.
+static double
+peak(double g0, double g1, double k) noexcept {
+    const double d = g1 - g0;
+    return k <= std::abs(d) ? std::max(g0, g1) : (g0 + g1) * 0.5 + k * 0.25 + d * d / (4.0 * k);
+}
+
+struct Sweep {
+    Mat2<double> margin;
+    double travel;
+};
+
+// Box and longest path of the object's corners over the motion. The path of a point is affine in where it starts, so
+// its length is convex there and no point of the object travels further than a corner.
+static Sweep
+sweep(const Context &context, const Delta &delta, double amt) noexcept {
+    const auto half = context.res * 0.5;
+    const std::array<Vec2<double>, 4> corners{Vec2(-half.x(), -half.y()), Vec2(half.x(), -half.y()),
+                                              Vec2(-half.x(), half.y()), Vec2(half.x(), half.y())};
+
+    double reach = 0.0;
+    for (const auto &c : corners) reach = std::max(reach, (c - context.pivot).norm<2>());
+
+    // Corners are followed over the whole motion with Q(a + h) = P(h) Q(a) S(h), Q being the linear part of the map of
+    // a. Steps are short enough that a peak between samples rises at most 1/16 px over them, and turn at most 1/64 rad
+    // or 1/64 in log scale, so their chords add up to the path length.
+    const double bound = delta.curvature(amt, reach);
+    const int segs = std::clamp(
+            static_cast<int>(std::ceil(std::max(amt * std::sqrt(bound * 2.0), delta.bend(amt) * 64.0))), 1, 4096);
+    const double k = bound * (amt / segs) * (amt / segs) * 0.5;
+
+    const auto step = delta.build_xform(amt, segs);
+    const auto p = step.xform.to_mat2();
+    const auto s = Diag2(step.scale[0], step.scale[1]);
+    const auto t = step.xform[2].to_vec2();
+    const auto d = step.drift.to_vec2();
+
+    auto q = Mat2<double>::identity();
+    auto prev = corners;
+    auto lo = -half, hi = half;
+    std::array<double, 4> len{};
+    for (int i = 1; i <= segs; ++i) {
+        const double a = static_cast<double>(i);
+        q = p * q * s;
+        for (std::size_t c = 0; c < corners.size(); ++c) {
+            const auto pt = q * (corners[c] - context.pivot + d * a) + t * a + context.pivot;
+            for (int j = 0; j < 2; ++j) {
+                hi[j] = std::max(hi[j], peak(prev[c][j], pt[j], k));
+                lo[j] = std::min(lo[j], -peak(-prev[c][j], -pt[j], k));
+            }
+            len[c] += (pt - prev[c]).norm<2>();
+            prev[c] = pt;
+        }
+    }
+
+    Sweep swept{{}, std::ranges::max(len)};
+    swept.margin[0] = (-half - lo).ceil();
+    swept.margin[1] = (hi - half).ceil();
+    return swept;
+}
+
+Mat2<double>
+resize(const Context &context, const Delta &delta, double amt) noexcept {
+    return sweep(context, delta, amt).margin;
+}
+
+// Length of the sample path from each of pts, relative to the pivot, into len; pts is walked along. Chord sum over
+// segments of at most 1/64 rad or 1/64 in log scale, walked with the shader's recurrence.
+static void
+path_lengths(const Delta &delta, double amt, std::span<Vec2<double>> pts, std::span<double> len) noexcept {
+    const int segs = std::clamp(static_cast<int>(std::ceil(delta.bend(amt) * 64.0)), 4, 4096);
+    const auto step = delta.build_xform(amt, segs, true);
+    const auto p = step.xform.to_mat2();
+    const auto s = Diag2(step.scale[0], step.scale[1]);
+    const auto d = step.drift.to_vec2();
+
+    auto t = step.xform[2].to_vec2();
+    auto scl = s;
+    auto drift = d;
+    auto scl_prev = Diag2(1.0, 1.0);
+    auto drift_prev = Vec2<double>();
+    std::ranges::fill(len, 0.0);
+    for (int k = 0; k < segs; ++k) {
+        for (std::size_t i = 0; i < pts.size(); ++i) {
+            const auto prev = scl_prev * pts[i] + drift_prev;
+            pts[i] = p * pts[i] + t;
+            len[i] += (scl * pts[i] + drift - prev).norm<2>();
+        }
+
+        scl_prev = scl;
+        drift_prev = drift;
+        t = p * t;
+        scl = scl * s;
+        drift += d;
+    }
+}
+
+double
+max_travel(const Context &context, const Delta &delta, double amt) noexcept {
+    return sweep(context, delta, amt).travel;
+}
+
+Tiles
+build_tiles(const Delta &delta, double amt, double spacing, int smp, int w, int h, const Vec2<double> &pivot,
+            int size) {
+    size = std::max(size, 1);
+    Tiles tiles{size, (std::max(w, 0) + size - 1) / size, (std::max(h, 0) + size - 1) / size, {}};
+    tiles.smp.assign(static_cast<std::size_t>(tiles.cols) * tiles.rows, 0);
+    if (tiles.smp.empty() || smp <= 0)
+        return tiles;
+
+    // Corners are shared between neighbouring tiles.
+    const int nx = tiles.cols + 1, ny = tiles.rows + 1;
+    std::vector<Vec2<double>> pts;
+    pts.reserve(static_cast<std::size_t>(nx) * ny);
+    for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i)
+            pts.emplace_back(std::min(i * size, w) - pivot.x(), std::min(j * size, h) - pivot.y());
+
+    std::vector<double> len(pts.size());
+    path_lengths(delta, amt, pts, len);
+
+    for (int j = 0; j < tiles.rows; ++j) {
+        for (int i = 0; i < tiles.cols; ++i) {
+            const std::size_t c = static_cast<std::size_t>(j) * nx + i;
+            const double travel = std::max({len[c], len[c + 1], len[c + nx], len[c + nx + 1]});
+            if (travel >= 1.0)
+                tiles.smp[static_cast<std::size_t>(j) * tiles.cols + i] =
+                        std::min(static_cast<int>(std::ceil(travel / spacing)), smp);
+        }
+    }
+
+    return tiles;
+}
+
+std::vector<double>
+build_taps(const Delta &delta, double amt, int smp) {
+    std::vector<double> taps;
+    taps.reserve(static_cast<std::size_t>(std::max(smp, 0)) * 6);
+
+    for (int i = 1; i <= smp; ++i) {
+        const auto m = delta.build_xform(amt * i / smp, 1, true).affine();
+        taps.insert(taps.end(), {m(0, 0), m(0, 1), m(0, 2), m(1, 0), m(1, 1), m(1, 2)});
+    }
+
+    return taps;
+}
+
+std::vector<Mat3<double>>
+build_passes(const Delta &delta, double amt, int num) {
+    std::vector<Mat3<double>> passes;
+    passes.reserve(num);
+
+    auto step = delta.build_xform(amt, (1 << num) - 1, true).affine();
+    for (int i = 0; i < num; ++i) {
+        passes.push_back(step);
+        step = step * step;
+    }
+
+    return passes;
+}
+
+void
+purge_cache(GeoCache &cache, const Param &param, const Context &context) {
+    switch (param.cache_purge) {
+        case 1:
+            if (context.frame != context.range - 1)
+                return;
+            break;
+        case 2:
+            cache.clear(context.name);
+            return;
+        case 3:
+            break;
+        default:
+            return;
+    }
+
+    auto lease = cache.acquire(context.name, context.scene, context.id);
+    lease.atlas().clear(context.id);
+    lease.history().clear(context.id);
+}
+
+std::optional<Transform>
+lookup_prev(GeoCache &cache, const Param &param, const Context &context, const Transform &curr) {
+    auto lease = cache.acquire(context.name, context.scene, context.id);
+    return lease.history().prev(context.id, context.idx, context.frame, param.ext, curr);
+}
+
+// Cache traffic before the delta: stores the current geo and sets flow.geo.prev to the cached one.
+static void
+load_cache(AtlasOct &atlas, const Param &param, const Context &context, Flow &flow) noexcept {
+    const bool save_ed = param.geo_cache == 2;
+    const bool save_st = param.geo_cache == 1 || (save_ed && (context.frame == 1 || context.frame == 2));
+
+    if (!param.geo_cache) {
+        if (flow.read_data())
+            flow.write_data(Geo());
+    }
+
+    if (save_st)
+        atlas.overwrite(context.id, context.idx, context.frame + 1, *flow.geo.curr);
+
+    if (param.geo_cache) {
+        if (!context.frame && param.ext)
+            extrapolate(atlas, param, context, flow);
+        else if (auto g = atlas.read(context.id, context.idx, save_ed ? 1 : context.frame))
+            flow.set_prev(*g);
+    }
+}
+
+static void
+store_cache(AtlasOct &atlas, const Param &param, const Context &context, const Flow &flow) noexcept {
+    if (param.geo_cache == 2)
+        atlas.write(context.id, context.idx, 1, *flow.geo.curr);
+}
+
+// Margins and sample counts. Touches no shared state.
+static Result
+measure(const Param &param, const Context &context, const Delta &delta) noexcept {
+    Result result{};
+
+    // Sub-pixel travel is culled: the blur would not be visible.
+    if (delta.is_moved()) {
+        if (const auto swept = sweep(context, delta, param.amt); swept.travel >= 1.0) {
+            result.margin = swept.margin;
+            result.req_smp = static_cast<int>(std::ceil(swept.travel / param.spacing));
+            result.smp = std::min(result.req_smp, param.smp_lim - 1);
+        }
+    }
+
+    return result;
+}
+
+// Preview Budget is in millions of samples x pixels per frame, the pixels being those of the canvas after Resize.
+// Objects without blur cost nothing.
+static void
+govern(GeoCache &cache, const Param &param, const Context &context, Result &result) {
+    if (!result.smp || param.smp_budget <= 0.0)
+        return;
+
+    const auto canvas = context.res + result.margin[0] + result.margin[1];
+    const Governor::Demand demand{result.smp + 1, result.req_smp + 1.0, canvas.x() * canvas.y()};
+    result.smp = cache.governor().admit(context, demand, param.smp_budget * 1.0e6) - 1;
+}
+
+int
+mip_level(int req_smp, int smp) noexcept {
+    if (smp <= 0 || req_smp <= smp)
+        return 0;
+
+    return std::max(static_cast<int>(std::bit_width(static_cast<unsigned>(req_smp / smp))) - 2, 0);
+}
+
+// mip_taps caps the samples; the travel they no longer cover falls to a coarser level of the pyramid.
+static void
+cap_taps(const Param &param, Result &result) noexcept {
+    if (param.mip_taps && result.smp >= param.mip_taps)
+        result.smp = param.mip_taps - 1;
+}
+
+static int
+select_lod(const Param &param, const Result &result) noexcept {
+    return param.mip_taps ? mip_level(result.req_smp, result.smp) : 0;
+}
+
+static Kernel
+select_kernel(const Delta &delta, int smp) noexcept {
+    if (!smp)
+        return Kernel::generic;
+    if (delta.is_translation())
+        return Kernel::translate;
+    if (delta.is_rotation())
+        return Kernel::rotate;
+    if (delta.is_zoom())
+        return Kernel::zoom;
+    return Kernel::generic;
+}
+
+// Cache Limit is in MiB.
+static void
+enforce_budget(GeoCache &cache, const Param &param) {
+    cache.set_budget(static_cast<std::size_t>(param.cache_limit * 1048576.0));
+    if (cache.is_over_budget())
+        cache.trim();
+}
+
+// The cache traffic after the result, shared by memoized and computed results.
+static void
+finish(GeoCache &cache, const Param &param, const Context &context, const Flow &flow) {
+    store_cache(cache.acquire(context.name, context.scene, context.id).atlas(), param, context, flow);
+    if (context.idx == context.num - 1 && param.cache_purge)
+        purge_cache(cache, param, context);
+
+    enforce_budget(cache, param);
+}
+
+Result
+compute(GeoCache &cache, const Param &param, const Context &context, Flow &flow) {
+    {
+        auto lease = cache.acquire(context.name, context.scene, context.id);
+        auto &atlas = lease.atlas();
+        lease.history().record(context.id, context.idx, context.num, context.frame, flow.xform.curr);
+        atlas.resize(context.id, context.idx, context.num, param.geo_cache);
+        load_cache(atlas, param, context, flow);
+    }
+
+    // A Preview Budget makes the sample count depend on the frames around, so those results are not memoized.
+    const bool memoize = param.smp_budget <= 0.0;
+    const auto key = Memo::key(param, context, flow, 0);
+    if (memoize) {
+        if (auto hit = cache.memo().find(key)) {
+            cache.stats().record_samples(hit->req_smp, hit->smp, param.smp_lim);
+            finish(cache, param, context, flow);
+            return std::move(*hit);
+        }
+    }
+
+    const auto delta = flow.delta();
+    auto result = measure(param, context, delta);
+    govern(cache, param, context, result);
+    cap_taps(param, result);
+
+    // Doubling needs a power of two samples; floor(log2(smp + 1)) passes, so the limit and the budget still hold.
+    int num = 0;
+    if (param.doubling && result.smp) {
+        num = std::bit_width(static_cast<unsigned>(result.smp + 1)) - 1;
+        result.smp = (1 << num) - 1;
+    }
+
+    result.motion = delta.build_xform(param.amt, result.smp, true);
+    result.lod = select_lod(param, result);
+    result.kernel = select_kernel(delta, result.smp);
+    cache.stats().record_samples(result.req_smp, result.smp, param.smp_lim);
+    if (num)
+        result.passes = build_passes(delta, param.amt, num);
+    else if (result.smp <= max_taps)
+        result.taps = build_taps(delta, param.amt, result.smp);
+
+    // Over the canvas after Resize, whose pivot sits where the script puts it.
+    if (param.tile) {
+        const auto canvas = context.res + result.margin[0] + result.margin[1];
+        const auto pivot = context.res * 0.5 + result.margin[0] + context.pivot;
+        result.tiles = build_tiles(delta, param.amt, param.spacing, result.smp, static_cast<int>(canvas.x()),
+                                   static_cast<int>(canvas.y()), pivot, param.tile);
+    }
+
+    if (memoize)
+        cache.memo().insert(key, result);
+
+    finish(cache, param, context, flow);
+    return result;
+}
+
+std::vector<Result>
+compute_batch(GeoCache &cache, const Param &param, std::span<const Context> contexts, std::span<Flow> flows) {
+    const std::size_t num = std::min(contexts.size(), flows.size());
+    if (!num)
+        return {};
+
+    // All indices share one id, hence one shard. The math in between runs in parallel without it.
+    const auto &front = contexts.front();
+    std::vector<Memo::Key> keys;
+    keys.reserve(num);
+    {
+        auto lease = cache.acquire(front.name, front.scene, front.id);
+        auto &atlas = lease.atlas();
+        for (std::size_t i = 0; i < num; ++i) {
+            const auto &context = contexts[i];
+            lease.history().record(context.id, context.idx, context.num, context.frame, flows[i].xform.curr);
+            atlas.resize(context.id, context.idx, context.num, param.geo_cache);
+            load_cache(atlas, param, context, flows[i]);
+            keys.push_back(Memo::key(param, context, flows[i], 1));
+        }
+    }
+
+    const bool memoize = param.smp_budget <= 0.0;
+    std::vector<Result> results(num);
+    Pool::shared().run(num, [&](std::size_t i) {
+        if (auto hit = memoize ? cache.memo().find(keys[i]) : std::nullopt) {
+            results[i] = std::move(*hit);
+        } else {
+            const auto delta = flows[i].delta();
+            results[i] = measure(param, contexts[i], delta);
+            govern(cache, param, contexts[i], results[i]);
+            cap_taps(param, results[i]);
+            results[i].lod = select_lod(param, results[i]);
+            results[i].motion = delta.build_xform(param.amt, results[i].smp, true);
+            results[i].kernel = select_kernel(delta, results[i].smp);
+            if (memoize)
+                cache.memo().insert(keys[i], results[i]);
+        }
+        cache.stats().record_samples(results[i].req_smp, results[i].smp, param.smp_lim);
+    });
+
+    {
+        auto lease = cache.acquire(front.name, front.scene, front.id);
+        for (std::size_t i = 0; i < num; ++i) store_cache(lease.atlas(), param, contexts[i], flows[i]);
+    }
+
+    for (const auto &context : contexts.first(num))
+        if (context.idx == context.num - 1 && param.cache_purge)
+            purge_cache(cache, param, context);
+
+    enforce_budget(cache, param);
+    return results;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "cache.hpp"
+#include "geo.hpp"
+#include "structs.hpp"
+#include "transform.hpp"
+#include "vector/vector.hpp"
+
+// Taps beyond the first that fit the constant buffer of motion_blur_table.hlsl, two registers each after the header.
+inline constexpr int max_taps = 2047;
+
+void extrapolate(AtlasOct &atlas, const Param &param, const Context &context, Flow &flow) noexcept;
+
+// Left-top and right-bottom margins that hold the object box over the whole motion: never inside the swept box, and
+// at most 1/16 px beyond it before rounding up.
+[[nodiscard]] Mat2<double> resize(const Context &context, const Delta &delta, double amt) noexcept;
+
+// Longest path, in pixels, that a point of the object travels over amt; it is one of the corners.
+[[nodiscard]] double max_travel(const Context &context, const Delta &delta, double amt) noexcept;
+
+// Samples each size x size tile of a w x h canvas needs, at most smp, for the blur about pivot (in texels, as the
+// shaders take it). A tile takes the longest sample path of its corner pixels, as the path is longest at a corner.
+[[nodiscard]] Tiles build_tiles(const Delta &delta, double amt, double spacing, int smp, int w, int h,
+                                const Vec2<double> &pivot, int size);
+
+// Pyramid level for smp taps where req_smp were asked for: the largest whose bilinear footprint, 2^(lod + 1) texels,
+// still fits between two taps. Coarser levels blur across the motion more than the missing taps would band.
+[[nodiscard]] int mip_level(int req_smp, int smp) noexcept;
+
+// Maps of taps 1 to smp in closed form, as row-major 2x3 affine matrices packed back to back. Tap i is the inverse
+// motion over amt * i / smp, which is where the recurrence of motion_blur.hlsl lands without its float round-off.
+[[nodiscard]] std::vector<double> build_taps(const Delta &delta, double amt, int smp);
+
+// Tap maps of the recursive-doubling mode: the inverse step of 2^num samples raised to 1, 2, 4, ... Each pass averages
+// its input with the input warped by its map, so num passes leave the average over every power of the step. That is
+// the path of build_xform for a translation, rotation or scale alone, not for translation combined with either: there
+// the shaders turn the translation of each step along with the image, which a power of the step keeps fixed, and the
+// last sample ends up about travel x angle / 2 away. bench_blur allows a mean of 3/255 off Blur there, 0.75 otherwise.
+[[nodiscard]] std::vector<Mat3<double>> build_passes(const Delta &delta, double amt, int num);
+
+void purge_cache(GeoCache &cache, const Param &param, const Context &context);
+
+// Previous track-bar transform from the history that compute() records, for calls that leave it to the module.
+[[nodiscard]] std::optional<Transform> lookup_prev(GeoCache &cache, const Param &param, const Context &context,
+                                                   const Transform &curr);
+
+// Portable body of compute_motion. Throws if the cache cannot be initialized. Safe to call concurrently; the shard of
+// context.id is held only around the cache traffic.
+[[nodiscard]] Result compute(GeoCache &cache, const Param &param, const Context &context, Flow &flow);
+
+// compute() for many individual objects of one id. Results hold no tap tables and ignore doubling; the caches are
+// read and written in index order as consecutive compute() calls would.
+[[nodiscard]] std::vector<Result> compute_batch(GeoCache &cache, const Param &param, std::span<const Context> contexts,
+                                                std::span<Flow> flows);
@@ -0,0 +1,168 @@
+#include "pool.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+// Set on workers and on a caller while it drains, where a nested run must not wait for the pool it is part of.
+static thread_local bool inside = false;
+
+Pool::Pool(unsigned workers) : queues(std::make_unique<Queue[]>(workers + 1)), lanes(workers + 1) {
+    threads.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) threads.emplace_back([this, i] { loop(i); });
+}
+
+Pool::~Pool() {
+    {
+        std::scoped_lock lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto &t : threads) t.join();
+}
+
+std::size_t
+Pool::run(std::span<const std::size_t> costs, const std::function<void(std::size_t)> &fn) {
+    if (costs.empty())
+        return 0;
+
+    if (inside) {
+        for (std::size_t i = 0; i < costs.size(); ++i) fn(i);
+        return 0;
+    }
+
+    std::scoped_lock exclusive(turn);
+    start(fn, costs.size());
+
+    // Longest processing time first: each task goes to the least loaded queue, which keeps it heaviest first.
+    std::vector<std::size_t> order(costs.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::ranges::stable_sort(order, std::ranges::greater{}, [&](std::size_t i) { return costs[i]; });
+
+    std::vector<std::size_t> load(lanes, 0);
+    for (const std::size_t i : order) {
+        const auto q = static_cast<std::size_t>(std::ranges::min_element(load) - load.begin());
+        load[q] += std::max<std::size_t>(costs[i], 1);
+        std::scoped_lock lock(queues[q].mutex);
+        queues[q].tasks.push_back(i);
+    }
+
+    return finish();
+}
+
+std::size_t
+Pool::run(std::size_t count, const std::function<void(std::size_t)> &fn) {
+    if (count == 0)
+        return 0;
+
+    if (inside) {
+        for (std::size_t i = 0; i < count; ++i) fn(i);
+        return 0;
+    }
+
+    std::scoped_lock exclusive(turn);
+    start(fn, count);
+
+    for (std::size_t q = 0; q < lanes; ++q) {
+        std::scoped_lock lock(queues[q].mutex);
+        for (std::size_t i = count * q / lanes; i < count * (q + 1) / lanes; ++i) queues[q].tasks.push_back(i);
+    }
+
+    return finish();
+}
+
+void
+Pool::start(const std::function<void(std::size_t)> &fn, std::size_t count) {
+    // Workers still leaving the last run may take a task as soon as it is dealt, so everything is set before.
+    job = &fn;
+    left.store(count);
+    stolen.store(0, std::memory_order_relaxed);
+}
+
+std::size_t
+Pool::finish() {
+    {
+        std::scoped_lock lock(mutex);
+        ++generation;
+    }
+    wake.notify_all();
+
+    inside = true;
+    drain(lanes - 1);
+    inside = false;
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&] { return left.load() == 0; });
+    job = nullptr;
+    if (auto error = std::exchange(failure, nullptr))
+        std::rethrow_exception(error);
+
+    return stolen.load(std::memory_order_relaxed);
+}
+
+Pool &
+Pool::shared() {
+    static Pool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+void
+Pool::loop(std::size_t self) {
+    inside = true;
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [&] { return stop || generation != seen; });
+            if (stop)
+                return;
+
+            seen = generation;
+        }
+        drain(self);
+    }
+}
+
+void
+Pool::drain(std::size_t self) {
+    std::size_t task;
+    while (take(self, task)) {
+        try {
+            (*job)(task);
+        } catch (...) {
+            std::scoped_lock lock(mutex);
+            if (!failure)
+                failure = std::current_exception();
+        }
+
+        if (left.fetch_sub(1) == 1) {
+            std::scoped_lock lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+bool
+Pool::take(std::size_t self, std::size_t &task) {
+    {
+        auto &own = queues[self];
+        std::scoped_lock lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for (std::size_t k = 1; k < lanes; ++k) {
+        auto &victim = queues[(self + k) % lanes];
+        std::scoped_lock lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool, the parallel backend of the module: the parallel algorithms of libstdc++ run serially without
+// TBB. A run deals the tasks out to one queue per worker; a worker takes its own from the front and once out steals
+// from the back of the others, so the tail of a run is spread over whatever is left. The calling thread works too, so
+// a pool of no workers runs everything in order on it, as does a run from inside a task.
+class Pool {
+public:
+    explicit Pool(unsigned workers);
+    ~Pool();
+
+    Pool(const Pool &) = delete;
+    Pool &operator=(const Pool &) = delete;
+
+    // Calls fn(i) once for every index of costs and returns when all are done, rethrowing the first exception of fn.
+    // Tasks are dealt heaviest first, each to the queue with the least cost so far, so the cheap ones are stolen last.
+    // Concurrent runs take turns. Returns how many tasks were stolen.
+    std::size_t run(std::span<const std::size_t> costs, const std::function<void(std::size_t)> &fn);
+
+    // Same for tasks [0, count) of equal cost, such as rows, dealt in contiguous runs to keep neighbours together.
+    std::size_t run(std::size_t count, const std::function<void(std::size_t)> &fn);
+
+    [[nodiscard]] std::size_t workers() const noexcept { return threads.size(); }
+
+    // One worker per hardware thread besides the caller, created on first use.
+    [[nodiscard]] static Pool &shared();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    std::unique_ptr<Queue[]> queues;
+    std::size_t lanes;
+    const std::function<void(std::size_t)> *job = nullptr;
+    std::atomic<std::size_t> left = 0;
+    std::atomic<std::size_t> stolen = 0;
+    std::exception_ptr failure;
+
+    std::mutex turn;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::uint64_t generation = 0;
+    bool stop = false;
+    std::vector<std::thread> threads;
+
+    // Arms the pool for count tasks of fn; then deal and finish, which works along and waits.
+    void start(const std::function<void(std::size_t)> &fn, std::size_t count);
+    std::size_t finish();
+
+    void loop(std::size_t self);
+    void drain(std::size_t self);
+    [[nodiscard]] bool take(std::size_t self, std::size_t &task);
+};
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "motion.hpp"
+#include "structs.hpp"
+#include "transform.hpp"
+
+// Marshalling between the script and the portable core. P is SCRIPT_MODULE_PARAM in the module and Host elsewhere;
+// both expose the same member call syntax.
+namespace script {
+template <typename P>
+[[nodiscard]] inline Param
+load_param(P *p, int idx) {
+    auto to_num = [&](const char *key) { return p->get_param_table_double(idx, key); };
+    auto to_int = [&](const char *key) { return p->get_param_table_int(idx, key); };
+    auto to_bool = [&](const char *key) { return p->get_param_table_boolean(idx, key); };
+
+    return Param(to_num("amt"), to_int("smp_lim"), to_num("smp_budget"), to_num("spacing"), to_bool("doubling"),
+                 to_int("ext"), to_int("geo_cache"), to_int("cache_purge"), to_num("cache_limit"), to_int("tile"),
+                 to_int("mip_taps"), to_bool("print_info"));
+}
+
+template <typename P>
+[[nodiscard]] inline Context
+load_context(P *p, int idx) {
+    auto to_num = [&](const char *key) { return p->get_param_table_double(idx, key); };
+    auto to_int = [&](const char *key) { return p->get_param_table_int(idx, key); };
+    auto to_string = [&](const char *key) { return p->get_param_table_string(idx, key); };
+    const char *scene = to_string("scene");
+
+    return Context(to_string("name"), to_num("w"), to_num("h"), to_num("cx"), to_num("cy"), to_int("id"), to_int("idx"),
+                   to_int("num"), to_int("frame"), to_int("range"), to_int("tick"), scene ? scene : "");
+}
+
+template <typename P>
+[[nodiscard]] inline Geo *
+load_data(P *p, int idx) {
+    auto data = reinterpret_cast<Geo *>(p->get_param_data(idx));
+    return data && p->get_param_int(idx + 1) == sizeof(Geo) ? data : nullptr;
+}
+
+template <typename P>
+[[nodiscard]] inline Call
+load_call(P *p, const Geo *data) {
+    auto to_num = [&](const char *key, int idx) { return p->get_param_table_double(idx, key); };
+
+    auto to_xform = [&](int idx) {
+        return Transform(to_num("cx", idx), to_num("cy", idx), to_num("x", idx), to_num("y", idx), to_num("rz", idx),
+                         to_num("sx", idx), to_num("sy", idx));
+    };
+
+    auto to_geo = [&](int idx, int frame) {
+        return Geo(frame, to_num("cx", idx), to_num("cy", idx), to_num("ox", idx), to_num("oy", idx),
+                   to_num("rz", idx), to_num("sx", idx), to_num("sy", idx));
+    };
+
+    Call call{load_param(p, 0), load_context(p, 1), {to_xform(2), to_xform(3)}, Geo(), std::nullopt};
+    call.geo = to_geo(4, call.context.frame);
+    if (data)
+        call.data = *data;
+
+    return call;
+}
+
+template <typename P>
+inline void
+push_result(P *p, const Result &result) {
+    auto margin = result.margin;
+    auto motion = result.motion;
+    auto scale = motion.scale.matrix();
+
+    const char *keys[] = {"left", "top", "right", "bottom"};
+    p->push_result_table_double(keys, margin.data(), static_cast<int>(margin.size()));
+    p->push_result_int(result.smp + 1);
+    p->push_result_array_double(motion.xform.data(), static_cast<int>(motion.xform.size()));
+    p->push_result_array_double(scale.data(), static_cast<int>(scale.size()));
+    p->push_result_array_double(motion.drift.data(), static_cast<int>(motion.drift.size()));
+
+    auto passes = result.passes;
+    auto taps = result.taps;
+    p->push_result_array_double(passes.empty() ? nullptr : passes.front().data(),
+                                static_cast<int>(passes.size() * Mat3<double>::size()));
+    p->push_result_array_double(taps.data(), static_cast<int>(taps.size()));
+
+    std::vector<int> tiles(result.tiles.smp.size());
+    std::ranges::transform(result.tiles.smp, tiles.begin(), [](int smp) { return smp + 1; });
+    p->push_result_array_int(tiles.data(), static_cast<int>(tiles.size()));
+    p->push_result_int(static_cast<int>(result.kernel));
+    p->push_result_int(result.lod);
+}
+
+// xform_prev = {cached = true} leaves the previous transform to the history of the module.
+template <typename P>
+[[nodiscard]] inline bool
+is_cached_prev(P *p, int idx) {
+    return p->get_param_table_boolean(idx, "cached");
+}
+
+// compute_motion(params, context, xform_curr, xform_prev, geo_curr[, data, size])
+// report(call, result) runs after a successful computation and before the results are pushed. With a cached
+// xform_prev that the history does not have, nothing is returned; call again with the transform.
+template <typename P, typename F>
+inline void
+compute_motion(P *p, GeoCache &cache, F &&report) {
+    const auto start = std::chrono::steady_clock::now();
+    const int n = p->get_param_num();
+    if (n != 5 && n != 7) {
+        p->set_error("Incorrect number of arguments");
+        return;
+    }
+
+    Geo *data = load_data(p, 5);
+    Call call = load_call(p, data);
+
+    std::optional<Result> result;
+    try {
+        if (is_cached_prev(p, 3)) {
+            const auto prev = lookup_prev(cache, call.param, call.context, call.xform.curr);
+            if (!prev)
+                return;
+
+            call.xform.prev = *prev;
+        }
+
+        Flow flow(call.xform.curr, call.xform.prev, call.geo, data);
+        result = compute(cache, call.param, call.context, flow);
+    } catch (...) {
+        p->set_error("Initialization failed");
+        return;
+    }
+
+    report(call, *result);
+    push_result(p, *result);
+    cache.stats().record_call(std::chrono::steady_clock::now() - start, 1);
+}
+
+// compute_motion_batch(params, context, xforms_curr, xforms_prev, geos_curr, sizes)
+// Arrays are flat per index: xforms as cx, cy, x, y, rz, sx, sy; geos as cx, cy, ox, oy, rz, sx, sy; sizes as the
+// w, h, cx, cy of context. context holds name, id, num, frame, range and tick. report(call, result) runs per index.
+// xforms_prev may be cached as in compute_motion; nothing is returned unless the history has every index.
+template <typename P, typename F>
+inline void
+compute_motion_batch(P *p, GeoCache &cache, F &&report) {
+    const auto start = std::chrono::steady_clock::now();
+    if (p->get_param_num() != 6) {
+        p->set_error("Incorrect number of arguments");
+        return;
+    }
+
+    const Param param = load_param(p, 0);
+    const Context shared = load_context(p, 1);
+    const int num = std::max(shared.num, 0);
+
+    const bool cached = is_cached_prev(p, 3);
+    constexpr std::pair<int, int> arrays[] = {{2, 7}, {3, 7}, {4, 7}, {5, 4}};
+    for (const auto &[idx, stride] : arrays) {
+        if ((idx != 3 || !cached) && p->get_param_array_num(idx) < num * stride) {
+            p->set_error("Incorrect array size");
+            return;
+        }
+    }
+
+    auto at = [&](int idx, int i) { return p->get_param_array_double(idx, i); };
+    auto to_xform = [&](int idx, int i) {
+        const int o = i * 7;
+        return Transform(at(idx, o), at(idx, o + 1), at(idx, o + 2), at(idx, o + 3), at(idx, o + 4), at(idx, o + 5),
+                         at(idx, o + 6));
+    };
+
+    // Flow points into itself, so flows must not reallocate.
+    std::vector<Call> calls;
+    std::vector<Context> contexts;
+    std::vector<Flow> flows;
+    calls.reserve(num);
+    contexts.reserve(num);
+    flows.reserve(num);
+
+    for (int i = 0; i < num; ++i) {
+        const int g = i * 7, s = i * 4;
+        contexts.emplace_back(shared.name, at(5, s), at(5, s + 1), at(5, s + 2), at(5, s + 3), shared.id, i, num,
+                              shared.frame, shared.range, shared.tick, shared.scene);
+
+        const Geo geo(shared.frame, at(4, g), at(4, g + 1), at(4, g + 2), at(4, g + 3), at(4, g + 4), at(4, g + 5),
+                      at(4, g + 6));
+        calls.push_back({param, contexts.back(), {to_xform(2, i), to_xform(3, i)}, geo, std::nullopt});
+        flows.emplace_back(calls.back().xform.curr, calls.back().xform.prev, geo, nullptr);
+    }
+
+    std::vector<Result> results;
+    try {
+        for (int i = 0; cached && i < num; ++i) {
+            const auto prev = lookup_prev(cache, param, contexts[i], calls[i].xform.curr);
+            if (!prev)
+                return;
+
+            calls[i].xform.prev = *prev;
+            flows[i].xform.prev = *prev;
+        }
+
+        results = compute_batch(cache, param, contexts, flows);
+    } catch (...) {
+        p->set_error("Initialization failed");
+        return;
+    }
+
+    std::vector<double> margins, xforms, scales, drifts;
+    std::vector<int> samples, kernels, lods;
+    margins.reserve(num * 4);
+    xforms.reserve(num * 9);
+    scales.reserve(num * 9);
+    drifts.reserve(num * 3);
+    samples.reserve(num);
+    kernels.reserve(num);
+    lods.reserve(num);
+
+    for (int i = 0; i < num; ++i) {
+        const auto &result = results[i];
+        report(calls[i], result);
+
+        const auto &motion = result.motion;
+        const auto scale = motion.scale.matrix();
+        margins.insert(margins.end(), result.margin.data(), result.margin.data() + result.margin.size());
+        xforms.insert(xforms.end(), motion.xform.data(), motion.xform.data() + motion.xform.size());
+        scales.insert(scales.end(), scale.data(), scale.data() + scale.size());
+        drifts.insert(drifts.end(), motion.drift.data(), motion.drift.data() + motion.drift.size());
+        samples.push_back(result.smp + 1);
+        kernels.push_back(static_cast<int>(result.kernel));
+        lods.push_back(result.lod);
+    }
+
+    p->push_result_array_double(margins.data(), static_cast<int>(margins.size()));
+    p->push_result_array_int(samples.data(), static_cast<int>(samples.size()));
+    p->push_result_array_double(xforms.data(), static_cast<int>(xforms.size()));
+    p->push_result_array_double(scales.data(), static_cast<int>(scales.size()));
+    p->push_result_array_double(drifts.data(), static_cast<int>(drifts.size()));
+    p->push_result_array_int(kernels.data(), static_cast<int>(kernels.size()));
+    p->push_result_array_int(lods.data(), static_cast<int>(lods.size()));
+    cache.stats().record_call(std::chrono::steady_clock::now() - start, num);
+}
+
+// cache_usage()
+template <typename P>
+inline void
+cache_usage(P *p, GeoCache &cache) {
+    const auto usage = cache.usage();
+
+    const char *keys[] = {"bytes", "budget", "ids", "pages", "evicted_ids", "evicted_pages"};
+    double values[] = {static_cast<double>(usage.bytes),       static_cast<double>(usage.budget),
+                       static_cast<double>(usage.ids),         static_cast<double>(usage.pages),
+                       static_cast<double>(usage.evicted_ids), static_cast<double>(usage.evicted_pages)};
+    p->push_result_table_double(keys, values, static_cast<int>(std::size(values)));
+}
+
+// stats([name])
+// Counters since the module was loaded, histogram buckets named by their upper edge, and bytes per script name or,
+// given name, per id of it.
+template <typename P>
+inline void
+stats(P *p, GeoCache &cache) {
+    const auto s = cache.stats().snapshot();
+    const auto usage = cache.usage();
+    const auto &traffic = usage.traffic;
+    const auto memo = cache.memo().counters();
+    const double lookups = static_cast<double>(std::max<std::uint64_t>(memo.hits + memo.misses, 1));
+    const double calls = static_cast<double>(std::max<std::uint64_t>(s.calls, 1));
+    const double reads =
+            static_cast<double>(std::max<std::uint64_t>(traffic.hits + traffic.file_hits + traffic.misses, 1));
+
+    std::vector<std::pair<std::string, double>> rows = {
+            {"calls", static_cast<double>(s.calls)},
+            {"indices", static_cast<double>(s.indices)},
+            {"latency_mean_us", static_cast<double>(s.latency_sum) / calls * 1.0e-3},
+            {"latency_p50_us", static_cast<double>(Stats::quantile(s.latency, 0.5)) * 1.0e-3},
+            {"latency_p90_us", static_cast<double>(Stats::quantile(s.latency, 0.9)) * 1.0e-3},
+            {"latency_p99_us", static_cast<double>(Stats::quantile(s.latency, 0.99)) * 1.0e-3},
+            {"latency_max_us", static_cast<double>(s.latency_max) * 1.0e-3},
+            {"clamped", static_cast<double>(s.clamped)},
+            {"requested_samples", static_cast<double>(s.requested)},
+            {"delivered_samples", static_cast<double>(s.delivered)},
+            {"samples_p50", static_cast<double>(Stats::quantile(s.samples, 0.5))},
+            {"samples_p90", static_cast<double>(Stats::quantile(s.samples, 0.9))},
+            {"samples_p99", static_cast<double>(Stats::quantile(s.samples, 0.99))},
+            {"hits", static_cast<double>(traffic.hits)},
+            {"file_hits", static_cast<double>(traffic.file_hits)},
+            {"misses", static_cast<double>(traffic.misses)},
+            {"hit_rate", static_cast<double>(traffic.hits + traffic.file_hits) / reads},
+            {"writes", static_cast<double>(traffic.writes)},
+            {"overwrites", static_cast<double>(traffic.overwrites)},
+            {"memo_hits", static_cast<double>(memo.hits)},
+            {"memo_misses", static_cast<double>(memo.misses)},
+            {"memo_hit_rate", static_cast<double>(memo.hits) / lookups},
+            {"memo_entries", static_cast<double>(memo.entries)},
+            {"memo_bytes", static_cast<double>(memo.bytes)},
+            {"bytes", static_cast<double>(usage.bytes)},
+            {"budget", static_cast<double>(usage.budget)},
+            {"ids", static_cast<double>(usage.ids)},
+            {"pages", static_cast<double>(usage.pages)},
+            {"evicted_ids", static_cast<double>(usage.evicted_ids)},
+            {"evicted_pages", static_cast<double>(usage.evicted_pages)}};
+
+    for (std::size_t k = 0; k < Stats::buckets; ++k) {
+        const auto edge = std::to_string(std::uint64_t{1} << k);
+        if (s.latency[k])
+            rows.emplace_back("latency_ns_lt_" + edge, static_cast<double>(s.latency[k]));
+        if (s.samples[k])
+            rows.emplace_back("samples_lt_" + edge, static_cast<double>(s.samples[k]));
+    }
+
+    if (const char *name = p->get_param_num() > 0 ? p->get_param_string(0) : nullptr) {
+        for (const auto &[id, size] : cache.bytes_by_id(name))
+            rows.emplace_back("bytes:" + std::to_string(id), static_cast<double>(size));
+    } else {
+        for (const auto &[key, size] : cache.bytes_by_name())
+            rows.emplace_back("bytes:" + key, static_cast<double>(size));
+    }
+
+    std::vector<const char *> keys;
+    std::vector<double> values;
+    for (const auto &[key, value] : rows) {
+        keys.push_back(key.c_str());
+        values.push_back(value);
+    }
+    p->push_result_table_double(keys.data(), values.data(), static_cast<int>(values.size()));
+}
+}  // namespace script
@@ -0,0 +1,69 @@
+#include "stats.hpp"
+
+void
+Stats::record_call(std::chrono::nanoseconds elapsed, int indices_) noexcept {
+    const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(elapsed.count(), 0));
+
+    calls.fetch_add(1, std::memory_order_relaxed);
+    indices.fetch_add(static_cast<std::uint64_t>(std::max(indices_, 0)), std::memory_order_relaxed);
+    latency_sum.fetch_add(ns, std::memory_order_relaxed);
+    latency[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    auto max = latency_max.load(std::memory_order_relaxed);
+    while (max < ns && !latency_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
+
+void
+Stats::record_samples(int req_smp, int smp, int smp_lim) noexcept {
+    requested.fetch_add(static_cast<std::uint64_t>(req_smp) + 1, std::memory_order_relaxed);
+    delivered.fetch_add(static_cast<std::uint64_t>(smp) + 1, std::memory_order_relaxed);
+    samples[bucket(static_cast<std::uint64_t>(req_smp) + 1)].fetch_add(1, std::memory_order_relaxed);
+    if (req_smp > smp_lim - 1)
+        clamped.fetch_add(1, std::memory_order_relaxed);
+}
+
+Stats::Snapshot
+Stats::snapshot() const noexcept {
+    Snapshot s{};
+    s.calls = calls.load(std::memory_order_relaxed);
+    s.indices = indices.load(std::memory_order_relaxed);
+    s.latency_sum = latency_sum.load(std::memory_order_relaxed);
+    s.latency_max = latency_max.load(std::memory_order_relaxed);
+    s.clamped = clamped.load(std::memory_order_relaxed);
+    s.requested = requested.load(std::memory_order_relaxed);
+    s.delivered = delivered.load(std::memory_order_relaxed);
+    for (std::size_t k = 0; k < buckets; ++k) {
+        s.latency[k] = latency[k].load(std::memory_order_relaxed);
+        s.samples[k] = samples[k].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+bool
+Stats::is_due(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::duration period) noexcept {
+    const std::int64_t t = now.time_since_epoch().count();
+    auto last = last_report.load(std::memory_order_relaxed);
+    if (last == 0) {
+        last_report.compare_exchange_strong(last, t, std::memory_order_relaxed);
+        return false;
+    }
+
+    return t - last >= period.count() && last_report.compare_exchange_strong(last, t, std::memory_order_relaxed);
+}
+
+std::uint64_t
+Stats::quantile(const Counts &counts, double q) noexcept {
+    std::uint64_t total = 0;
+    for (auto c : counts) total += c;
+    if (!total)
+        return 0;
+
+    const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t k = 0; k < buckets; ++k) {
+        seen += counts[k];
+        if (seen >= rank)
+            return k ? std::uint64_t{1} << k : 0;
+    }
+    return std::uint64_t{1} << (buckets - 1);
+}
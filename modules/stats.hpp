@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide counters of compute_motion. Lock-free, so any thread may record.
+class Stats {
+public:
+    // Bucket k counts values in [2^(k - 1), 2^k), bucket 0 zero; the last one takes everything above.
+    static constexpr std::size_t buckets = 40;
+    using Counts = std::array<std::uint64_t, buckets>;
+
+    struct Snapshot {
+        std::uint64_t calls;
+        std::uint64_t indices;
+        std::uint64_t latency_sum;
+        std::uint64_t latency_max;
+        Counts latency;
+        std::uint64_t clamped;
+        std::uint64_t requested;
+        std::uint64_t delivered;
+        Counts samples;
+    };
+
+    Stats() = default;
+
+    Stats(const Stats &) = delete;
+    Stats &operator=(const Stats &) = delete;
+
+    // One module call over indices individual objects.
+    void record_call(std::chrono::nanoseconds elapsed, int indices) noexcept;
+
+    // One individual object: req_smp and smp as in Result, with smp_lim the limit it was given.
+    void record_samples(int req_smp, int smp, int smp_lim) noexcept;
+
+    [[nodiscard]] Snapshot snapshot() const noexcept;
+
+    // True for the first caller once period has passed since the last time.
+    [[nodiscard]] bool is_due(std::chrono::steady_clock::time_point now,
+                              std::chrono::steady_clock::duration period) noexcept;
+
+    [[nodiscard]] static constexpr std::size_t bucket(std::uint64_t v) noexcept {
+        return std::min<std::size_t>(std::bit_width(v), buckets - 1);
+    }
+
+    // Upper edge of the bucket holding quantile q of counts. Zero when empty.
+    [[nodiscard]] static std::uint64_t quantile(const Counts &counts, double q) noexcept;
+
+private:
+    std::atomic<std::uint64_t> calls = 0;
+    std::atomic<std::uint64_t> indices = 0;
+    std::atomic<std::uint64_t> latency_sum = 0;
+    std::atomic<std::uint64_t> latency_max = 0;
+    std::array<std::atomic<std::uint64_t>, buckets> latency{};
+    std::atomic<std::uint64_t> clamped = 0;
+    std::atomic<std::uint64_t> requested = 0;
+    std::atomic<std::uint64_t> delivered = 0;
+    std::array<std::atomic<std::uint64_t>, buckets> samples{};
+    std::atomic<std::int64_t> last_report = 0;
+};
@@ -0,0 +1,241 @@
+#include "store.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+GeoFile::GeoFile(const std::filesystem::path &path, int id, std::uint64_t key, int num) noexcept {
+    if (num <= 0)
+        return;
+
+    std::size_t bytes = 0;
+#ifdef _WIN32
+    file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return;
+    }
+
+    if (LARGE_INTEGER n; GetFileSizeEx(file, &n))
+        bytes = static_cast<std::size_t>(n.QuadPart);
+#else
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return;
+
+    if (struct stat st; ::fstat(fd, &st) == 0)
+        bytes = static_cast<std::size_t>(st.st_size);
+#endif
+
+    // Anything written by another version or build, or for another object, starts over.
+    bool valid = false;
+    if (bytes >= header_bytes && (bytes - header_bytes) % block_bytes == 0 && map(bytes)) {
+        const auto &h = header();
+        valid = std::memcmp(h.magic, magic, sizeof(magic)) == 0 && h.version == version && h.size == sizeof(Geo) &&
+                h.block == block && h.key == key && h.id == id;
+    }
+
+    if (!valid) {
+        unmap();
+        if (!truncate() || !map(header_bytes))
+            return;
+
+        auto &h = header();
+        std::memcpy(h.magic, magic, sizeof(magic));
+        h.version = version;
+        h.size = sizeof(Geo);
+        h.block = block;
+        h.key = key;
+        h.id = id;
+    }
+
+    try {
+        scan(num);
+    } catch (...) {
+        unmap();
+    }
+}
+
+GeoFile::~GeoFile() noexcept {
+    unmap();
+#ifdef _WIN32
+    if (file)
+        CloseHandle(file);
+#else
+    if (fd >= 0)
+        ::close(fd);
+#endif
+}
+
+void
+GeoFile::resize(int num) {
+    if (!view || num <= 0 || num == header().num)
+        return;
+
+    for (std::size_t idx = num; idx < table.size(); ++idx) {
+        for (const std::uint32_t b : table[idx]) {
+            if (b) {
+                head(b - 1).owner = 0;
+                spare.push_back(b - 1);
+            }
+        }
+    }
+
+    table.resize(num);
+    header().num = num;
+}
+
+const Geo *
+GeoFile::read(int idx, int pos) const noexcept {
+    if (!view || idx < 0 || idx >= header().num || pos < 0)
+        return nullptr;
+
+    const auto &list = table[idx];
+    const std::size_t first = pos / block;
+    if (first >= list.size() || !list[first])
+        return nullptr;
+
+    const auto &geo = slots(list[first] - 1)[pos % block];
+    return geo.is_valid() ? &geo : nullptr;
+}
+
+void
+GeoFile::write(int idx, int pos, const Geo &geo) noexcept {
+    if (!view || idx < 0 || idx >= header().num || pos < 0)
+        return;
+
+    const std::size_t first = pos / block;
+    if (const auto &list = table[idx]; first >= list.size() || !list[first]) {
+        try {
+            if (!claim(idx, first))
+                return;
+        } catch (...) {
+            return;
+        }
+    }
+
+    slots(table[idx][first] - 1)[pos % block] = geo;
+}
+
+void
+GeoFile::scan(int num) {
+    header().num = num;
+    table.assign(num, {});
+    spare.clear();
+
+    // Free blocks go on the stack last first, so the lowest is reused first.
+    const std::size_t count = blocks();
+    for (std::size_t b = count; b-- > 0;) {
+        auto &h = head(b);
+        if (h.owner == 0 || h.owner > static_cast<std::uint32_t>(num)) {
+            h.owner = 0;
+            spare.push_back(static_cast<std::uint32_t>(b));
+            continue;
+        }
+
+        auto &list = table[h.owner - 1];
+        if (list.size() <= h.first)
+            list.resize(h.first + 1);
+        list[h.first] = static_cast<std::uint32_t>(b + 1);
+    }
+}
+
+bool
+GeoFile::claim(int idx, std::size_t first) {
+    auto &list = table[idx];
+    if (list.size() <= first)
+        list.resize(first + 1);
+
+    if (spare.empty()) {
+        const std::size_t count = blocks();
+        const std::size_t grown = std::max<std::size_t>(count * 2, 4);
+        spare.reserve(grown - count);
+        if (!map(header_bytes + grown * block_bytes))
+            return false;
+
+        for (std::size_t b = grown; b-- > count;) spare.push_back(static_cast<std::uint32_t>(b));
+    }
+
+    const std::uint32_t b = spare.back();
+    spare.pop_back();
+
+    std::memset(static_cast<void *>(slots(b)), 0, block * sizeof(Geo));
+    head(b) = {static_cast<std::uint32_t>(idx + 1), static_cast<std::uint32_t>(first)};
+    list[first] = b + 1;
+    return true;
+}
+
+bool
+GeoFile::map(std::size_t bytes) noexcept {
+#ifdef _WIN32
+    if (!file)
+        return false;
+
+    // A mapping larger than the file extends it.
+    void *grown = CreateFileMappingW(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(bytes >> 32),
+                                     static_cast<DWORD>(bytes), nullptr);
+    if (!grown)
+        return false;
+
+    auto *ptr = static_cast<std::byte *>(MapViewOfFile(grown, FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+    if (!ptr) {
+        CloseHandle(grown);
+        return false;
+    }
+
+    unmap();
+    mapping = grown;
+#else
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+        return false;
+
+    void *ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    unmap();
+#endif
+
+    view = static_cast<std::byte *>(ptr);
+    size = bytes;
+    return true;
+}
+
+bool
+GeoFile::truncate() noexcept {
+#ifdef _WIN32
+    LARGE_INTEGER n;
+    n.QuadPart = 0;
+    return file && SetFilePointerEx(file, n, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+#else
+    return fd >= 0 && ::ftruncate(fd, 0) == 0;
+#endif
+}
+
+void
+GeoFile::unmap() noexcept {
+    if (!view)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    ::munmap(view, size);
+#endif
+
+    view = nullptr;
+    size = 0;
+}
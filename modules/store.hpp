@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "transform.hpp"
+
+// Geo history of one object id in a memory-mapped file, in native byte order.
+//   header: "OMBG", u32 version, u32 sizeof(Geo), u32 block, u64 key, i32 id, i32 num, padded to header_bytes
+//   blocks: u32 idx + 1 (0 when free), u32 pos / block, then block Geos for positions from there
+// Every index owns the blocks of its own positions, listed by a scan on open, so neither a change of num nor a longer
+// history moves a record: the file only grows, and blocks of indices cut off by a smaller num are reused. Slots never
+// written are zero, which reads as an invalid Geo. A file of another version, key or id starts over.
+class GeoFile {
+public:
+    static constexpr char magic[4] = {'O', 'M', 'B', 'G'};
+    static constexpr std::uint32_t version = 2;
+    static constexpr std::size_t header_bytes = 32;
+    static constexpr int block = 64;
+
+    // key identifies the project and scene of id, which only together name the object.
+    GeoFile(const std::filesystem::path &path, int id, std::uint64_t key, int num) noexcept;
+    ~GeoFile() noexcept;
+
+    GeoFile(const GeoFile &) = delete;
+    GeoFile &operator=(const GeoFile &) = delete;
+
+    [[nodiscard]] bool is_open() const noexcept { return view != nullptr; }
+
+    // Changes the number of indices. Kept indices keep their history.
+    void resize(int num);
+
+    // nullptr unless a valid Geo is stored. Valid until the next write or resize.
+    [[nodiscard]] const Geo *read(int idx, int pos) const noexcept;
+
+    // Grows the file as needed; a failed grow drops the write.
+    void write(int idx, int pos, const Geo &geo) noexcept;
+
+    // Blocks in the file, in use or free.
+    [[nodiscard]] std::size_t blocks() const noexcept { return view ? (size - header_bytes) / block_bytes : 0; }
+
+private:
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t size;
+        std::uint32_t block;
+        std::uint64_t key;
+        std::int32_t id;
+        std::int32_t num;
+    };
+
+    struct Block {
+        std::uint32_t owner;
+        std::uint32_t first;
+    };
+
+    static constexpr std::size_t block_bytes = sizeof(Block) + block * sizeof(Geo);
+
+    static_assert(sizeof(Header) <= header_bytes && header_bytes % alignof(Geo) == 0);
+    static_assert(sizeof(Block) % alignof(Geo) == 0);
+
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    std::byte *view = nullptr;
+    std::size_t size = 0;
+    // Per index, 1 + the block of each run of block positions, 0 where none is written yet.
+    std::vector<std::vector<std::uint32_t>> table;
+    std::vector<std::uint32_t> spare;
+
+    [[nodiscard]] Header &header() const noexcept { return *reinterpret_cast<Header *>(view); }
+    [[nodiscard]] Block &head(std::size_t b) const noexcept {
+        return *reinterpret_cast<Block *>(view + header_bytes + b * block_bytes);
+    }
+    [[nodiscard]] Geo *slots(std::size_t b) const noexcept {
+        return reinterpret_cast<Geo *>(view + header_bytes + b * block_bytes + sizeof(Block));
+    }
+
+    // Lists the blocks of indices below num and frees the rest.
+    void scan(int num);
+    // Block of idx for positions from first * block, taken from the spare ones or grown into. False if the file
+    // cannot grow.
+    [[nodiscard]] bool claim(int idx, std::size_t first);
+
+    // Grows the file to bytes, at least the size mapped, and maps all of it. On failure the old view stays.
+    [[nodiscard]] bool map(std::size_t bytes) noexcept;
+    void unmap() noexcept;
+    // Empties the file; nothing may be mapped.
+    [[nodiscard]] bool truncate() noexcept;
+};
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <algorithm>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "transform.hpp"
 #include "vector/vector.hpp"
@@ -9,17 +11,31 @@
 struct Param {
     double amt;
     int smp_lim;
+    double smp_budget;
+    double spacing;
+    bool doubling;
     int ext;
     int geo_cache;
     int cache_purge;
+    double cache_limit;
+    int tile;
+    int mip_taps;
     bool print_info;
 
-    constexpr Param(double amt_, int smp_lim_, int ext_, int geo_cache_, int cache_purge_, bool print_info_) noexcept :
+    constexpr Param(double amt_, int smp_lim_, double smp_budget_, double spacing_, bool doubling_, int ext_,
+                    int geo_cache_, int cache_purge_, double cache_limit_, int tile_, int mip_taps_,
+                    bool print_info_) noexcept :
         amt(std::max(amt_, 0.0)),
         smp_lim(std::max(smp_lim_, 1)),
+        smp_budget(std::max(smp_budget_, 0.0)),
+        spacing(spacing_ > 0.0 ? std::max(spacing_, 0.1) : 1.0),
+        doubling(doubling_),
         ext(std::clamp(ext_, 0, 2)),
         geo_cache(std::clamp(geo_cache_, 0, 2)),
         cache_purge(std::clamp(cache_purge_, 0, 3)),
+        cache_limit(std::max(cache_limit_, 0.0)),
+        tile(std::clamp(tile_, 0, 4096)),
+        mip_taps(std::clamp(mip_taps_, 0, 4096)),
         print_info(print_info_) {}
 };
 
@@ -30,10 +46,15 @@ struct Context {
     int id, idx, num;
     int frame;
     int range;
+    // Frame on the timeline, shared by every object of one output frame; 0 when the script does not pass it.
+    int tick;
+    // Project and scene of the object, within which id is unique; empty when the script does not pass them.
+    std::string scene;
 
     constexpr Context(const std::string &name_, double w, double h, double cx, double cy, int id_, int idx_, int num_,
-                      int frame_, int range_) noexcept :
-        name(name_), res(w, h), pivot(cx, cy), id(id_), idx(idx_), num(num_), frame(frame_), range(range_) {}
+                      int frame_, int range_, int tick_ = 0, const std::string &scene_ = {}) noexcept :
+        name(name_), res(w, h), pivot(cx, cy), id(id_), idx(idx_), num(num_), frame(frame_), range(range_),
+        tick(tick_), scene(scene_) {}
 };
 
 template <typename T>
@@ -46,6 +67,7 @@ struct Flow {
 private:
     Geo *data;
     Geo curr;
+    Geo prev;
 
 public:
     Data<Transform> xform;
@@ -61,9 +83,53 @@ public:
 
     [[nodiscard]] constexpr const Geo *read_data() const noexcept { return data && data->is_valid() ? data : nullptr; }
 
+    // Previous geo decoded from the cache, held by the flow itself.
+    constexpr void set_prev(const Geo &v) noexcept {
+        prev = v;
+        geo.prev = &prev;
+    }
+
     [[nodiscard]] Delta delta() noexcept {
         xform.curr.set_geo(*geo.curr);
         xform.prev.set_geo(*geo.prev);
         return Delta(xform.curr, xform.prev);
     }
 };
+
+// Samples needed over a canvas cut into size x size tiles, row-major; smp as in Result. The tiles of the last row and
+// column are clipped to the canvas.
+struct Tiles {
+    int size;
+    int cols, rows;
+    std::vector<int> smp;
+};
+
+// Kernels that can render a Result besides the generic taps, cheaper when they apply. The script receives the value.
+enum class Kernel {
+    generic,
+    translate,
+    rotate,
+    zoom
+};
+
+struct Result {
+    Mat2<double> margin;
+    int req_smp;
+    int smp;
+    // Level of the prefiltered pyramid the taps sample, 2^lod texels per texel; 0 is the image itself.
+    int lod;
+    Kernel kernel;
+    Delta::Motion motion;
+    std::vector<Mat3<double>> passes;
+    std::vector<double> taps;
+    Tiles tiles;
+};
+
+// Inputs of one compute_motion call as received from the script.
+struct Call {
+    Param param;
+    Context context;
+    Data<Transform> xform;
+    Geo geo;
+    std::optional<Geo> data;
+};
@@ -0,0 +1,164 @@
+#include "trace.hpp"
+
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+struct Packed {
+    double amt, smp_budget, spacing, cache_limit;
+    std::int32_t smp_lim, doubling, ext, geo_cache, cache_purge, tile, mip_taps, print_info;
+    std::int32_t id, idx, num, frame, range, tick, has_data;
+    std::uint32_t scene;
+    double w, h, cx, cy;
+    std::array<double, 7> curr, prev, geo;
+    Geo data;
+};
+
+static_assert(std::is_trivially_copyable_v<Packed>);
+
+template <typename T>
+static void
+put(std::ofstream &file, const T &value) {
+    file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+[[nodiscard]] static bool
+get(std::ifstream &file, T &value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template <typename T>
+[[nodiscard]] static std::array<double, 7>
+to_array(const T &v) noexcept {
+    std::array<double, 7> data;
+    for (std::size_t i = 0; i < data.size(); ++i) data[i] = v[i];
+    return data;
+}
+
+[[nodiscard]] static Transform
+to_xform(const std::array<double, 7> &v) noexcept {
+    return Transform(v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+}
+
+[[nodiscard]] static Packed
+pack(const Call &call, std::uint32_t scene) noexcept {
+    const auto &[param, context, xform, geo, data] = call;
+    return {param.amt,
+            param.smp_budget,
+            param.spacing,
+            param.cache_limit,
+            param.smp_lim,
+            param.doubling,
+            param.ext,
+            param.geo_cache,
+            param.cache_purge,
+            param.tile,
+            param.mip_taps,
+            param.print_info,
+            context.id,
+            context.idx,
+            context.num,
+            context.frame,
+            context.range,
+            context.tick,
+            data.has_value(),
+            scene,
+            context.res.x(),
+            context.res.y(),
+            context.pivot.x(),
+            context.pivot.y(),
+            to_array(xform.curr),
+            to_array(xform.prev),
+            to_array(geo),
+            data.value_or(Geo())};
+}
+
+[[nodiscard]] static Call
+unpack(const Packed &p, const std::string &name, const std::string &scene) {
+    const auto &g = p.geo;
+    return {Param(p.amt, p.smp_lim, p.smp_budget, p.spacing, p.doubling, p.ext, p.geo_cache, p.cache_purge,
+                  p.cache_limit, p.tile, p.mip_taps, p.print_info),
+            Context(name, p.w, p.h, p.cx, p.cy, p.id, p.idx, p.num, p.frame, p.range, p.tick, scene),
+            {to_xform(p.curr), to_xform(p.prev)},
+            Geo(p.frame, g[0], g[1], g[2], g[3], g[4], g[5], g[6]),
+            p.has_data ? std::optional<Geo>(p.data) : std::nullopt};
+}
+
+trace::Writer::Writer(const std::string &path) : mutex(), file(path, std::ios::binary | std::ios::trunc), names() {
+    if (!file.is_open())
+        return;
+
+    file.write(magic, sizeof(magic));
+    put(file, version);
+}
+
+void
+trace::Writer::write(const Call &call) {
+    if (!file.is_open())
+        return;
+
+    std::scoped_lock lock(mutex);
+    auto intern = [&](const std::string &s) {
+        const auto [it, inserted] = names.try_emplace(s, static_cast<std::uint32_t>(names.size()));
+        if (inserted) {
+            put(file, std::uint8_t{0});
+            put(file, static_cast<std::uint32_t>(s.size()));
+            file.write(s.data(), static_cast<std::streamsize>(s.size()));
+        }
+        return it->second;
+    };
+
+    const std::uint32_t name = intern(call.context.name);
+    const std::uint32_t scene = intern(call.context.scene);
+    put(file, std::uint8_t{1});
+    put(file, name);
+    put(file, pack(call, scene));
+}
+
+trace::Reader::Reader(const std::string &path) : file(path, std::ios::binary), names(), valid(false) {
+    char head[sizeof(magic)];
+    std::uint32_t ver = 0;
+
+    if (file.read(head, sizeof(head)) && get(file, ver))
+        valid = std::memcmp(head, magic, sizeof(magic)) == 0 && ver == version;
+}
+
+std::optional<Call>
+trace::Reader::read() {
+    while (valid) {
+        std::uint8_t tag = 0;
+        if (!get(file, tag))
+            return std::nullopt;
+
+        if (tag == 0) {
+            std::uint32_t size = 0;
+            if (!get(file, size))
+                break;
+
+            std::string name(size, '\0');
+            if (!file.read(name.data(), size))
+                break;
+
+            names.push_back(std::move(name));
+            continue;
+        }
+
+        std::uint32_t name = 0;
+        Packed packed;
+        if (tag != 1 || !get(file, name) || !get(file, packed) || name >= names.size() || packed.scene >= names.size())
+            break;
+
+        return unpack(packed, names[name], names[packed.scene]);
+    }
+
+    valid = false;
+    return std::nullopt;
+}
+
+std::vector<Call>
+trace::Reader::read_all() {
+    std::vector<Call> calls;
+    while (auto call = read()) calls.push_back(std::move(*call));
+    return calls;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "structs.hpp"
+
+// Binary trace of compute_motion inputs, in native byte order.
+//   header: "OMBT", u32 version
+//   record: u8 tag, then
+//     tag 0 (string): u32 length, bytes. Appended to the table of script names and scenes.
+//     tag 1 (call): u32 name index, fixed-size call record (Packed in trace.cpp) holding the scene index.
+namespace trace {
+inline constexpr char magic[4] = {'O', 'M', 'B', 'T'};
+inline constexpr std::uint32_t version = 9;
+
+class Writer {
+public:
+    explicit Writer(const std::string &path);
+
+    [[nodiscard]] bool is_open() const noexcept { return file.is_open(); }
+
+    // Safe to call from concurrent compute calls; records are appended whole.
+    void write(const Call &call);
+
+private:
+    std::mutex mutex;
+    std::ofstream file;
+    std::unordered_map<std::string, std::uint32_t> names;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string &path);
+
+    [[nodiscard]] bool is_open() const noexcept { return file.is_open() && valid; }
+
+    // Returns std::nullopt at the end of the trace or on a malformed record.
+    [[nodiscard]] std::optional<Call> read();
+
+    // Reads every remaining call.
+    [[nodiscard]] std::vector<Call> read_all();
+
+private:
+    std::ifstream file;
+    std::vector<std::string> names;
+    bool valid;
+};
+}  // namespace trace
@@ -1,12 +1,15 @@
 #include "transform.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 Delta::Delta(const Transform &from, const Transform &to) noexcept :
     base(from.scale().inverse()),
     scale(base * to.scale()),
     pos(base * (to.position() - from.position()).rotate(-from.rotation())),
     center(from.center() - to.center()),
     rot(to.rotation() - from.rotation()),
-    flag(is_zero(pos.norm(2)) && is_zero(center.norm(2)) && is_zero(scale.determinant() - 1.0) && is_zero(rot)) {}
+    flag(is_zero(pos.norm<2>()) && is_zero(center.norm<2>()) && is_zero(scale.determinant() - 1.0) && is_zero(rot)) {}
 
 Delta::Motion
 Delta::build_xform(double amt, int smp, bool inverse) const noexcept {
@@ -29,3 +32,20 @@ Delta::build_xform(double amt, int smp, bool inverse) const noexcept {
         return {Mat3<double>::identity(), Diag3<double>::identity(), Vec3<double>()};
     }
 }
+
+double
+Delta::bend(double amt) const noexcept {
+    return std::max({std::abs(rot), std::abs(std::log(scale[0])), std::abs(std::log(scale[1]))}) * amt;
+}
+
+double
+Delta::curvature(double amt, double reach) const noexcept {
+    // The linear part is base R(rot a) base^-1 scale^a. Each derivative brings down at most |rot| + |log scale|, and
+    // conjugating by base stretches by at most its aspect; the drift is linear in a.
+    const double rate = std::abs(rot) + std::max(std::abs(std::log(scale[0])), std::abs(std::log(scale[1])));
+    const double grow = std::max({1.0, std::pow(scale[0], amt), std::pow(scale[1], amt)});
+    const double bx = std::abs(base[0]), by = std::abs(base[1]);
+    const double aspect = std::max(bx, by) / std::min(bx, by);
+    const double drift = center.norm<2>();
+    return aspect * grow * rate * (rate * (reach + drift * amt) + 2.0 * drift);
+}
@@ -40,6 +40,7 @@ public:
     }
 
     [[nodiscard]] constexpr bool is_valid() const noexcept { return flag; }
+    [[nodiscard]] constexpr int get_frame() const noexcept { return frame; }
 
 private:
     std::int32_t flag;
@@ -80,14 +81,45 @@ public:
         Mat3<double> xform;
         Diag3<double> scale;
         Vec3<double> drift;
+
+        // The map of one tap as a single matrix: scale * xform, then drift.
+        [[nodiscard]] constexpr Mat3<double> affine() const noexcept {
+            auto m = scale * xform;
+            m[2] += drift;
+            return m;
+        }
     };
 
     Delta(const Transform &from, const Transform &to) noexcept;
 
     [[nodiscard]] constexpr bool is_moved() const noexcept { return !flag; }
 
+    // No rotation and no scale change: every tap is the last one moved by the same offset.
+    [[nodiscard]] bool is_translation() const noexcept {
+        return is_zero(rot) && is_zero(scale[0] - 1.0) && is_zero(scale[1] - 1.0);
+    }
+
+    // Only a turn about the pivot, which stays a rotation on screen: the object is not stretched.
+    [[nodiscard]] bool is_rotation() const noexcept {
+        return is_zero(pos.norm<2>()) && is_zero(center.norm<2>()) && is_zero(scale[0] - 1.0) &&
+               is_zero(scale[1] - 1.0) && is_zero(base[0] / base[1] - 1.0);
+    }
+
+    // Only a uniform scale change about the pivot, so every point moves straight away from it or towards it.
+    [[nodiscard]] bool is_zoom() const noexcept {
+        return is_zero(pos.norm<2>()) && is_zero(center.norm<2>()) && is_zero(rot) &&
+               is_zero(scale[0] / scale[1] - 1.0);
+    }
+
     [[nodiscard]] Motion build_xform(double amt, int smp = 1, bool inverse = false) const noexcept;
 
+    // Largest rotation or log scale change over amt. Zero for a pure translation, whose path is straight.
+    [[nodiscard]] double bend(double amt) const noexcept;
+
+    // Bound on the second derivative, over the fraction a in [0, amt], of where the map of a takes a point that starts
+    // at most reach from the pivot and drifts with the center. Zero for a pure translation.
+    [[nodiscard]] double curvature(double amt, double reach) const noexcept;
+
 private:
     Diag2<double> base;
     Diag2<double> scale;
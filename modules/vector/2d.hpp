@@ -50,6 +50,11 @@ public:
         return (*this)(0, 0) * (*this)(1, 1) - (*this)(1, 0) * (*this)(0, 1);
     }
 
+    [[nodiscard]] constexpr Mat2 inverse() const {
+        const T r = T(1) / determinant();
+        return Mat2(Vec2((*this)(1, 1) * r, -(*this)(1, 0) * r), Vec2(-(*this)(0, 1) * r, (*this)(0, 0) * r));
+    }
+
     [[nodiscard]] static constexpr Mat2 rotation(T theta, T scale = T(1)) {
         const T c = std::cos(theta) * scale;
         const T s = std::sin(theta) * scale;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdexcept>
+
 #include "2d.hpp"
 
 template <std::floating_point T>
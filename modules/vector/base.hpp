@@ -5,13 +5,13 @@
 #include <cmath>
 #include <concepts>
 #include <cstddef>
-#include <execution>
 #include <numeric>
 #include <ranges>
-#include <stdexcept>
 #include <type_traits>
 #include <utility>
 
+#include "simd.hpp"
+
 namespace vector {
 template <typename V_Derived, std::size_t N, std::floating_point T>
 class Vec {
@@ -101,22 +101,20 @@ public:
         return result;
     }
 
-    [[nodiscard]] constexpr T norm(int ord = 2) const {
-        switch (ord) {
-            case 1: {
-                T sum = T(0);
-                for (T v : vec) sum += std::abs(v);
-                return sum;
-            }
-            case 2: {
-                T sum = T(0);
-                for (T v : vec) sum += v * v;
-                return std::sqrt(sum);
-            }
-            case -1:
-                return std::ranges::max(vec | std::views::transform([](T v) { return std::abs(v); }));
-            default:
-                throw std::invalid_argument("unsupported norm");
+    template <int Ord = 2>
+    [[nodiscard]] constexpr T norm() const noexcept {
+        static_assert(Ord == 1 || Ord == 2 || Ord == -1, "unsupported norm");
+
+        if constexpr (Ord == 1) {
+            return [&]<std::size_t... I>(std::index_sequence<I...>) {
+                return (T(0) + ... + std::abs(vec[I]));
+            }(std::make_index_sequence<N>{});
+        } else if constexpr (Ord == 2) {
+            return [&]<std::size_t... I>(std::index_sequence<I...>) {
+                return std::sqrt((T(0) + ... + (vec[I] * vec[I])));
+            }(std::make_index_sequence<N>{});
+        } else {
+            return std::ranges::max(vec | std::views::transform([](T v) { return std::abs(v); }));
         }
     }
 
@@ -226,29 +224,32 @@ public:
     }
 
     [[nodiscard]] constexpr M_Derived operator*(const M_Derived &other) const noexcept {
-        constexpr auto idx = std::views::iota(0, N);
-
         M_Derived result;
-        std::for_each(std::execution::par_unseq, idx.begin(), idx.end(), [&](std::size_t k) {
-            const auto &vec = other[k];
-            for (std::size_t j = 0; j < N; ++j) {
-                const T &v = vec[j];
-                for (std::size_t i = 0; i < N; ++i) {
-                    result[k][i] += (*this)[j][i] * v;
-                }
+        if !consteval {
+            if constexpr (simd::enabled<N, T>) {
+                simd::mul_mat<N>(data(), other.data(), result.data());
+                return result;
             }
-        });
+        }
+
+        [&]<std::size_t... K>(std::index_sequence<K...>) {
+            ((result[K] = (*this) * other[K]), ...);
+        }(std::make_index_sequence<N>{});
         return result;
     }
 
     [[nodiscard]] constexpr V_Derived operator*(const V_Derived &vec) const noexcept {
         V_Derived result;
-        for (std::size_t j = 0; j < N; ++j) {
-            const T &v = vec[j];
-            for (std::size_t i = 0; i < N; ++i) {
-                result[i] += (*this)[j][i] * v;
+        if !consteval {
+            if constexpr (simd::enabled<N, T>) {
+                simd::mul_vec<N>(data(), vec.data(), result.data());
+                return result;
             }
         }
+
+        [&]<std::size_t... J>(std::index_sequence<J...>) {
+            ((result += cols[J] * vec[J]), ...);
+        }(std::make_index_sequence<N>{});
         return result;
     }
 
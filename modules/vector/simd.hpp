@@ -0,0 +1,112 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#define VECTOR_SIMD_SSE2
+#endif
+
+#if defined(__AVX2__)
+#define VECTOR_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(VECTOR_SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace vector::simd {
+#if defined(VECTOR_SIMD_SSE2)
+inline constexpr bool sse2 = true;
+#else
+inline constexpr bool sse2 = false;
+#endif
+
+#if defined(VECTOR_SIMD_AVX2)
+inline constexpr bool avx2 = true;
+#else
+inline constexpr bool avx2 = false;
+#endif
+
+// Column-major products of packed N x N double matrices. Only sizes with a matching register width are provided.
+template <std::size_t N, typename T>
+inline constexpr bool enabled = std::same_as<T, double> && ((N == 2 && sse2) || (N == 3 && avx2));
+
+#if defined(VECTOR_SIMD_SSE2)
+inline void
+mul_vec2(const double *m, const double *v, double *r) noexcept {
+    const __m128d c0 = _mm_mul_pd(_mm_loadu_pd(m), _mm_set1_pd(v[0]));
+    const __m128d c1 = _mm_mul_pd(_mm_loadu_pd(m + 2), _mm_set1_pd(v[1]));
+    _mm_storeu_pd(r, _mm_add_pd(c0, c1));
+}
+
+inline void
+mul_mat2(const double *a, const double *b, double *r) noexcept {
+    mul_vec2(a, b, r);
+    mul_vec2(a, b + 2, r + 2);
+}
+#endif
+
+#if defined(VECTOR_SIMD_AVX2)
+// Loads the three columns with full-width loads; the last one is rotated down from an in-bounds window.
+inline void
+load_cols3(const double *m, __m256d &c0, __m256d &c1, __m256d &c2) noexcept {
+    c0 = _mm256_loadu_pd(m);
+    c1 = _mm256_loadu_pd(m + 3);
+    c2 = _mm256_permute4x64_pd(_mm256_loadu_pd(m + 5), _MM_SHUFFLE(0, 3, 2, 1));
+}
+
+inline void
+store3(double *r, __m256d v) noexcept {
+    _mm_storeu_pd(r, _mm256_castpd256_pd128(v));
+    _mm_store_sd(r + 2, _mm256_extractf128_pd(v, 1));
+}
+
+inline __m256d
+mul_cols3(__m256d c0, __m256d c1, __m256d c2, const double *v) noexcept {
+    const __m256d r = _mm256_add_pd(_mm256_mul_pd(c0, _mm256_set1_pd(v[0])), _mm256_mul_pd(c1, _mm256_set1_pd(v[1])));
+    return _mm256_add_pd(r, _mm256_mul_pd(c2, _mm256_set1_pd(v[2])));
+}
+
+inline void
+mul_vec3(const double *m, const double *v, double *r) noexcept {
+    __m256d c0, c1, c2;
+    load_cols3(m, c0, c1, c2);
+    store3(r, mul_cols3(c0, c1, c2, v));
+}
+
+inline void
+mul_mat3(const double *a, const double *b, double *r) noexcept {
+    __m256d c0, c1, c2;
+    load_cols3(a, c0, c1, c2);
+    store3(r, mul_cols3(c0, c1, c2, b));
+    store3(r + 3, mul_cols3(c0, c1, c2, b + 3));
+    store3(r + 6, mul_cols3(c0, c1, c2, b + 6));
+}
+#endif
+
+template <std::size_t N>
+inline void
+mul_vec([[maybe_unused]] const double *m, [[maybe_unused]] const double *v, [[maybe_unused]] double *r) noexcept {
+#if defined(VECTOR_SIMD_SSE2)
+    if constexpr (N == 2)
+        mul_vec2(m, v, r);
+#endif
+#if defined(VECTOR_SIMD_AVX2)
+    if constexpr (N == 3)
+        mul_vec3(m, v, r);
+#endif
+}
+
+template <std::size_t N>
+inline void
+mul_mat([[maybe_unused]] const double *a, [[maybe_unused]] const double *b, [[maybe_unused]] double *r) noexcept {
+#if defined(VECTOR_SIMD_SSE2)
+    if constexpr (N == 2)
+        mul_mat2(a, b, r);
+#endif
+#if defined(VECTOR_SIMD_AVX2)
+    if constexpr (N == 3)
+        mul_mat3(a, b, r);
+#endif
+}
+}  // namespace vector::simd
@@ -0,0 +1,28 @@
+Texture2D src : register(t0);
+SamplerState smp : register(s0);
+cbuffer params : register(b0) {
+    float2 res;
+    // Offset of every tap from the last, in pixels.
+    float2 step;
+    float n;
+    float mix;
+};
+
+static const float2 texel = rcp(res);
+
+struct PS_Input {
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+};
+
+float4 motion_blur_line(PS_Input input) : SV_Target {
+    const uint count = uint(n);
+    const float2 d = step * texel;
+    const float4 base = src.Load(int3(input.pos.xy, 0));
+
+    float4 col = base;
+    for (uint i = 1; i < count; ++i) col += src.Sample(smp, mad(float(i), d, input.uv));
+
+    col = col * rcp(n);
+    return col + base * (1.0 - col.a) * mix;
+}
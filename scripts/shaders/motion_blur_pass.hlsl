@@ -0,0 +1,24 @@
+Texture2D src : register(t0);
+Texture2D base : register(t1);
+SamplerState smp : register(s0);
+cbuffer params : register(b0) {
+    column_major float3x3 xform;
+    float2 res;
+    float2 pivot;
+    float mix;
+};
+
+static const float2 texel = rcp(res);
+
+struct PS_Input {
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+};
+
+float4 motion_blur_pass(PS_Input input) : SV_Target {
+    float3 pos = float3(mad(input.uv, res, -pivot), 1.0);
+    float2 uv = (mul(xform, pos).xy + pivot) * texel;
+
+    float4 col = (src.Load(int3(input.pos.xy, 0)) + src.Sample(smp, uv)) * 0.5;
+    return col + base.Load(int3(input.pos.xy, 0)) * (1.0 - col.a) * mix;
+}
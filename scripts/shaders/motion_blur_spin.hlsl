@@ -0,0 +1,35 @@
+Texture2D src : register(t0);
+SamplerState smp : register(s0);
+cbuffer params : register(b0) {
+    float2 res;
+    float2 pivot;
+    float n;
+    float mix;
+    // Cosine and sine of the turn of every tap from the last.
+    float2 turn;
+};
+
+static const float2 texel = rcp(res);
+
+struct PS_Input {
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+};
+
+float4 motion_blur_spin(PS_Input input) : SV_Target {
+    const uint count = uint(n);
+    const float angle = atan2(turn.y, turn.x);
+    const float2 pos = mad(input.uv, res, -pivot);
+    const float4 base = src.Load(int3(input.pos.xy, 0));
+
+    float4 col = base;
+    for (uint i = 1; i < count; ++i) {
+        float s, c;
+        sincos(angle * float(i), s, c);
+        const float2 q = float2(c * pos.x - s * pos.y, s * pos.x + c * pos.y);
+        col += src.Sample(smp, (q + pivot) * texel);
+    }
+
+    col = col * rcp(n);
+    return col + base * (1.0 - col.a) * mix;
+}
@@ -0,0 +1,33 @@
+Texture2D src : register(t0);
+SamplerState smp : register(s0);
+cbuffer params : register(b0) {
+    float2 res;
+    float2 pivot;
+    float n;
+    float mix;
+    // Rows of the 2x3 map of taps 1 to n - 1, two registers per tap.
+    float4 taps[4094];
+};
+
+static const float2 texel = rcp(res);
+
+struct PS_Input {
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+};
+
+float4 motion_blur_table(PS_Input input) : SV_Target {
+    const uint count = uint(n);
+    const float3 pos = float3(mad(input.uv, res, -pivot), 1.0);
+    const float4 base = src.Load(int3(input.pos.xy, 0));
+
+    float4 col = base;
+    for (uint i = 1; i < count; ++i) {
+        const uint k = (i - 1) * 2;
+        const float2 q = float2(dot(taps[k].xyz, pos), dot(taps[k + 1].xyz, pos));
+        col += src.Sample(smp, (q + pivot) * texel);
+    }
+
+    col = col * rcp(n);
+    return col + base * (1.0 - col.a) * mix;
+}
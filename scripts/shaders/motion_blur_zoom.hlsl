@@ -0,0 +1,30 @@
+Texture2D src : register(t0);
+SamplerState smp : register(s0);
+cbuffer params : register(b0) {
+    float2 res;
+    float2 pivot;
+    float n;
+    float mix;
+    // Scale of every tap from the last about the pivot.
+    float factor;
+};
+
+static const float2 texel = rcp(res);
+
+struct PS_Input {
+    float4 pos : SV_Position;
+    float2 uv : TEXCOORD;
+};
+
+float4 motion_blur_zoom(PS_Input input) : SV_Target {
+    const uint count = uint(n);
+    const float log_factor = log2(factor);
+    const float2 pos = mad(input.uv, res, -pivot);
+    const float4 base = src.Load(int3(input.pos.xy, 0));
+
+    float4 col = base;
+    for (uint i = 1; i < count; ++i) col += src.Sample(smp, mad(pos, exp2(log_factor * float(i)), pivot) * texel);
+
+    col = col * rcp(n);
+    return col + base * (1.0 - col.a) * mix;
+}